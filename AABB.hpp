@@ -0,0 +1,46 @@
+#ifndef AABB_HPP
+#define AABB_HPP
+
+#include <limits>
+
+#include <glm/glm.hpp>
+
+// axis aligned bounding box, empty (invalid) by default
+struct AABB {
+    glm::vec3 min{ std::numeric_limits<float>::max() };
+    glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+    bool valid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+    void extend(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void extend(const AABB& other) {
+        if (other.valid()) {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+    }
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 size() const { return max - min; }
+
+    /* Box containing this box transformed by a matrix
+     * @param m: transformation
+     */
+    AABB transformed(const glm::mat4& m) const {
+        AABB result;
+        if (!valid()) {
+            return result;
+        }
+        for (int i = 0; i < 8; ++i) {
+            glm::vec3 corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+            result.extend(glm::vec3(m * glm::vec4(corner, 1.0f)));
+        }
+        return result;
+    }
+};
+
+#endif // AABB_HPP
@@ -19,7 +19,25 @@
 #include "Door.hpp"
 #include "ShaderProgram.hpp"
 #include "StatusBar.hpp"
+#include "ClusteredLighting.hpp"
 #include "Light.hpp"
+#include "LightBuffer.hpp"
+#include "LightVisibility.hpp"
+#include "OcclusionQueries.hpp"
+#include "PortalCulling.hpp"
+#include "RenderQueue.hpp"
+#include "SceneGrid.hpp"
+#include "SpriteRenderer.hpp"
+#include "FrameUniforms.hpp"
+#include "IndirectRenderer.hpp"
+#include "InstancedRenderer.hpp"
+#include "StaticLevelMesh.hpp"
+#include "WeightedOIT.hpp"
+#include "DeferredRenderer.hpp"
+#include "LightmapBaker.hpp"
+#include "ShaderWatcher.hpp"
+#include "PipelinePrewarm.hpp"
+#include "RingBuffer.hpp"
 
 enum class TextureFilter {
     Nearest,       // Nearest neighbor - rychlé, ale nekvalitní
@@ -27,6 +45,11 @@ enum class TextureFilter {
     TrilinearMipmap // Trilineární filtrování s MIPMAP - nejlepší kvalita, vyšší paměťové nároky
 };
 
+// per-frame render statistics, shown in the ImGui info window
+struct RenderStats {
+    int draw_calls = 0;
+};
+
 // our application class 
 class App {
 public:
@@ -43,6 +66,7 @@ public:
 	char webcam_to_movement(const cv::Point2f& center);
     
     static GLuint gen_tex(cv::Mat& image, TextureFilter filter);
+    static GLuint gen_tex_array(std::vector<cv::Mat>& images, TextureFilter filter);
 
     ~App(); //default destructor, called on app instance destruction
 private:
@@ -54,8 +78,12 @@ private:
     // list of bullets
     std::vector<Bullet> bullets;
     // list of lights
-    const int MAX_LIGHTS = 20;
     std::vector<Light> lights;
+    LightBuffer light_buffer; // lights in SSBO, see upload_lights()
+    bool clustered_lighting_enabled = true; // shade only lights of the fragment's cluster
+    ClusteredLighting clustered_lighting;
+    bool light_visibility_enabled = true; // skip lights hidden behind walls (baked per tile)
+    LightVisibility light_visibility;
 
     // camera related 
     Camera camera;
@@ -74,10 +102,55 @@ private:
 
     // list of Models
     std::unordered_map<std::string, ShaderProgram> shader_cache;
+    ShaderWatcher shader_watcher; // edited shaders are recompiled while running (see update_shaders)
+    int shader_reloads = 0;
     std::unordered_map<std::string, Model> model_cache;
     std::vector<std::unique_ptr<Model>> models;
+    unsigned models_version = 0; // incremented whenever models are added or removed
     //ShaderProgram shader;
 
+    // rendering
+    RenderStats render_stats;
+    RenderQueue render_queue; // per-model draws sorted by state
+    bool frustum_culling = true; // draw only models in the view frustum
+    SceneGrid scene_grid;
+    bool portal_culling = true; // draw only models in rooms seen through open doors
+    PortalCulling portal_culler;
+    bool occlusion_queries = false; // draw sprites conditionally on their bounding box passing the depth test
+    OcclusionQueries occlusion;
+    bool sprite_billboarding = true; // sprites as one instanced batch turned to the camera in the vertex shader
+    SpriteRenderer sprite_renderer;
+    bool oit_enabled = false; // weighted blended order-independent transparency instead of sorted blending
+    WeightedOIT weighted_oit;
+    ShaderProgram* oit_shader = nullptr; // transparent models in the OIT pass
+    InstancedRenderer oit_instanced_renderer; // transparent map models in the OIT pass, batched by token
+    std::vector<Model*> transparent_models; // collected by render_opaque, reused every frame
+    std::vector<Model*> cutout_models; // alpha tested models of the frame (see render_cutout)
+    bool alpha_to_coverage = false; // cutout edges by alpha-to-coverage (needs a multisampled framebuffer)
+    bool z_prepass = false; // depth-only pass of lit geometry, then shading with GL_EQUAL
+    ShaderProgram* depth_shader = nullptr;
+    ShaderProgram* depth_indirect_shader = nullptr;
+    bool deferred_shading = false; // opaque geometry into a G-buffer, lit once per pixel in a fullscreen pass
+    DeferredRenderer deferred_renderer;
+    ShaderProgram* gbuffer_shader = nullptr;
+    ShaderProgram* gbuffer_array_shader = nullptr; // G-buffer pass of the indirect renderer
+    bool lightmaps_enabled = false; // baked static level lit from a lightmap instead of the light loop
+    LightmapBaker lightmap_baker;
+    ShaderProgram* lightmap_shader = nullptr;
+    PipelinePrewarm pipeline_prewarm; // first draw of every prototype at level load (see prewarm_pipeline)
+    RingBuffer stream_buffer; // persistently mapped memory for data written every frame
+    FrameUniforms frame_uniforms; // v_m, p_m, camera position and time for all shaders
+    bool instanced_rendering = false; // draw opaque map models grouped by token
+    InstancedRenderer instanced_renderer;
+    ShaderProgram* instanced_lit_shader = nullptr;
+    ShaderProgram* instanced_lit_array_shader = nullptr;
+    ShaderProgram* instanced_unlit_shader = nullptr;
+    bool static_level_enabled = true; // draw baked walls instead of wall models
+    StaticLevelMesh static_level;
+    bool indirect_rendering = false; // draw array-textured models with glMultiDrawElementsIndirect
+    IndirectRenderer indirect_renderer;
+    ShaderProgram* indirect_shader = nullptr;
+
     // webcam
     cv::VideoCapture capture;
     cv::CascadeClassifier face_cascade; // Face cascade classifier
@@ -109,8 +182,23 @@ private:
     void init_gl_debug();
     void init_assets(void);
     void init_map_for_level_and_generate_scene(int level);
+    void init_texture_arrays(const nlohmann::json& map_models);
     bool webcam_init();
     void clasificator_init();
+    ShaderProgram& cached_shader(const std::filesystem::path& vertex_shader_path,
+                                 const std::filesystem::path& fragment_shader_path,
+                                 const std::vector<std::string>& defines = {});
+    void update_shaders();
+
+    // render
+    void set_light_uniforms(ShaderProgram& shader, const glm::mat4& view_matrix);
+    void upload_lights();
+    glm::vec3 sprite_rotation(const Model& model);
+    void render_opaque(const glm::mat4& view_matrix, float delta_t, std::vector<Model*>& transparent);
+    void render_cutout(std::vector<Model*>& cutout);
+    void render_transparent(std::vector<Model*>& transparent);
+    void prewarm_pipeline();
+    int prewarm_model(Model& prototype, const glm::mat4& view_matrix);
 
     // print info
     void print_opencv_info();
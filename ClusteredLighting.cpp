@@ -0,0 +1,139 @@
+#include "ClusteredLighting.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "LightBuffer.hpp"
+
+void ClusteredLighting::init(RingBuffer& stream) {
+    clear();
+    this->stream = &stream;
+    // shaders read the header even if clustering is off, valid grid for draws before the first frame
+    update(false, {}, glm::mat4(1.0f), glm::mat4(1.0f), 1, 1);
+}
+
+int ClusteredLighting::slice(float depth) {
+    // logarithmic slices: near clusters are thin, far clusters are deep
+    int s = (int)std::floor(std::log(depth / NEAR) / std::log(FAR / NEAR) * SLICES);
+    return std::clamp(s, 0, SLICES - 1);
+}
+
+void ClusteredLighting::update(bool enabled, const std::vector<Light>& lights, const glm::mat4& view_matrix,
+                               const glm::mat4& projection_matrix, int width, int height) {
+    if (stream == nullptr) {
+        return;
+    }
+
+    GridHeader header{};
+    header.grid_size = glm::uvec4(TILES_X, TILES_Y, SLICES, enabled ? 1 : 0);
+    float log_range = std::log(FAR / NEAR);
+    header.depth_params = glm::vec4(SLICES / log_range, SLICES * std::log(NEAR) / log_range, 0.0f, 0.0f);
+    header.screen_size = glm::vec4((float)glm::max(width, 1), (float)glm::max(height, 1), 0.0f, 0.0f);
+
+    max_lights_per_cluster = 0;
+    light_indices = 0;
+    if (!enabled) {
+        clusters.clear();
+        indices.assign(1, 0);
+        upload(header);
+        return;
+    }
+
+    // cluster range of every light from its view space bounding box
+    bounds.clear();
+    for (size_t i = 0; i < lights.size(); ++i) {
+        const Light& light = lights[i];
+        float range = LightBuffer::light_range(light);
+        if (!light.isActive || range <= 0.0f) {
+            continue;
+        }
+        glm::vec3 center = glm::vec3(view_matrix * glm::vec4(light.position, 1.0f));
+        float depth_min = -center.z - range;
+        float depth_max = -center.z + range;
+        if (depth_max < NEAR) {
+            // behind the camera
+            continue;
+        }
+        depth_min = glm::max(depth_min, NEAR);
+
+        // project the box corners, extremes of x/depth and y/depth are in the corners
+        glm::vec2 ndc_min(1.0f);
+        glm::vec2 ndc_max(-1.0f);
+        for (float depth : { depth_min, depth_max }) {
+            for (float dx : { -range, range }) {
+                for (float dy : { -range, range }) {
+                    glm::vec4 clip = projection_matrix * glm::vec4(center.x + dx, center.y + dy, -depth, 1.0f);
+                    glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                    ndc_min = glm::min(ndc_min, ndc);
+                    ndc_max = glm::max(ndc_max, ndc);
+                }
+            }
+        }
+        if (ndc_max.x < -1.0f || ndc_max.y < -1.0f || ndc_min.x > 1.0f || ndc_min.y > 1.0f) {
+            // outside of the view frustum
+            continue;
+        }
+
+        LightBounds light_bounds;
+        light_bounds.light = (GLuint)i;
+        light_bounds.min = glm::ivec3(std::clamp((int)std::floor((ndc_min.x * 0.5f + 0.5f) * TILES_X), 0, TILES_X - 1),
+                                      std::clamp((int)std::floor((ndc_min.y * 0.5f + 0.5f) * TILES_Y), 0, TILES_Y - 1),
+                                      slice(depth_min));
+        light_bounds.max = glm::ivec3(std::clamp((int)std::floor((ndc_max.x * 0.5f + 0.5f) * TILES_X), 0, TILES_X - 1),
+                                      std::clamp((int)std::floor((ndc_max.y * 0.5f + 0.5f) * TILES_Y), 0, TILES_Y - 1),
+                                      slice(depth_max));
+        bounds.push_back(light_bounds);
+    }
+
+    auto cluster_index = [](int x, int y, int z) { return x + TILES_X * (y + TILES_Y * z); };
+
+    // count lights per cluster, prefix sum to offsets, then fill the index list
+    clusters.assign(TILES_X * TILES_Y * SLICES, glm::uvec2(0));
+    for (const auto& b : bounds) {
+        for (int z = b.min.z; z <= b.max.z; ++z)
+            for (int y = b.min.y; y <= b.max.y; ++y)
+                for (int x = b.min.x; x <= b.max.x; ++x)
+                    clusters[cluster_index(x, y, z)].y++;
+    }
+    GLuint offset = 0;
+    for (auto& cluster : clusters) {
+        cluster.x = offset;
+        offset += cluster.y;
+        max_lights_per_cluster = glm::max(max_lights_per_cluster, (int)cluster.y);
+        cluster.y = 0;
+    }
+    indices.resize(glm::max(offset, 1u));
+    for (const auto& b : bounds) {
+        for (int z = b.min.z; z <= b.max.z; ++z)
+            for (int y = b.min.y; y <= b.max.y; ++y)
+                for (int x = b.min.x; x <= b.max.x; ++x) {
+                    glm::uvec2& cluster = clusters[cluster_index(x, y, z)];
+                    indices[cluster.x + cluster.y++] = b.light;
+                }
+    }
+    light_indices = (int)offset;
+
+    upload(header);
+}
+
+void ClusteredLighting::upload(const GridHeader& header) {
+    // header and cluster ranges are one SSBO, the default alignment of the ring fits storage bindings
+    GLsizeiptr clusters_size = clusters.size() * sizeof(glm::uvec2);
+    RingBuffer::Allocation grid = stream->allocate(sizeof(GridHeader) + clusters_size);
+    std::memcpy(grid.data, &header, sizeof(GridHeader));
+    if (clusters_size > 0) {
+        std::memcpy(static_cast<char*>(grid.data) + sizeof(GridHeader), clusters.data(), clusters_size);
+    }
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, GRID_BINDING, grid.buffer, grid.offset, grid.size);
+
+    RingBuffer::Allocation index = stream->push(indices.data(), indices.size() * sizeof(GLuint));
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, INDEX_BINDING, index.buffer, index.offset, index.size);
+}
+
+void ClusteredLighting::clear() {
+    stream = nullptr;
+    bounds.clear();
+    clusters.clear();
+    indices.clear();
+}
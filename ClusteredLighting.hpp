@@ -0,0 +1,79 @@
+#ifndef CLUSTEREDLIGHTING_HPP
+#define CLUSTEREDLIGHTING_HPP
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Light.hpp"
+#include "RingBuffer.hpp"
+
+/* Clustered forward lighting: the view frustum is split into TILES_X x TILES_Y screen tiles
+ * and SLICES logarithmic depth slices (froxels). Every frame each light is assigned on the CPU
+ * to the froxels its range touches, lighting shaders then loop only over the lights
+ * of the fragment's cluster, so per-pixel cost does not grow with the number of lights.
+ * The cluster ranges and light indices are written to the stream ring every frame.
+ */
+class ClusteredLighting {
+public:
+    static constexpr GLuint GRID_BINDING = 2;  // SSBO binding point of cluster ranges
+    static constexpr GLuint INDEX_BINDING = 3; // SSBO binding point of light indices
+    static constexpr int TILES_X = 16;
+    static constexpr int TILES_Y = 9;
+    static constexpr int SLICES = 24;
+    // depth range of slices, everything farther falls into the last slice
+    static constexpr float NEAR = 0.1f;  // must match near plane in App::update_projection_matrix
+    static constexpr float FAR = 100.0f;
+
+    // statistics of the last update
+    int max_lights_per_cluster = 0;
+    int light_indices = 0;
+
+    ClusteredLighting() = default;
+    ClusteredLighting(const ClusteredLighting&) = delete;
+    ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+    ~ClusteredLighting() { clear(); }
+
+    /* @param stream: ring the grid and the light indices are written to every frame
+     */
+    void init(RingBuffer& stream);
+
+    /* Assign lights to clusters and upload them
+     * @param enabled: false = shaders loop over all lights
+     * @param lights: lights of the level (same order as in LightBuffer)
+     * @param view_matrix: current view matrix
+     * @param projection_matrix: current projection matrix
+     * @param width, height: framebuffer size
+     */
+    void update(bool enabled, const std::vector<Light>& lights, const glm::mat4& view_matrix,
+                const glm::mat4& projection_matrix, int width, int height);
+
+    void clear();
+
+private:
+    // header of the grid SSBO, std430 layout (see ClusterGrid in lighting.frag)
+    struct GridHeader {
+        glm::uvec4 grid_size;
+        glm::vec4 depth_params;
+        glm::vec4 screen_size;
+    };
+    // cluster range of one light
+    struct LightBounds {
+        GLuint light;
+        glm::ivec3 min;
+        glm::ivec3 max;
+    };
+
+    RingBuffer* stream = nullptr;
+
+    // kept between frames to avoid reallocations
+    std::vector<LightBounds> bounds;
+    std::vector<glm::uvec2> clusters;
+    std::vector<GLuint> indices;
+
+    static int slice(float depth);
+    void upload(const GridHeader& header);
+};
+
+#endif // CLUSTEREDLIGHTING_HPP
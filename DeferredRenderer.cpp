@@ -0,0 +1,111 @@
+#include "DeferredRenderer.hpp"
+
+#include <stdexcept>
+
+void DeferredRenderer::create_targets(int width, int height) {
+    delete_targets();
+    this->width = width;
+    this->height = height;
+
+    const GLenum formats[TARGETS] = { GL_RGBA8, GL_RGBA16F, GL_RGBA8, GL_RGBA8, GL_RGBA8 };
+    glCreateTextures(GL_TEXTURE_2D, TARGETS, textures);
+    for (int i = 0; i < TARGETS; i++) {
+        glTextureStorage2D(textures[i], 1, formats[i], width, height);
+    }
+    // same format as the default framebuffer, so the depth can be blitted back
+    glCreateTextures(GL_TEXTURE_2D, 1, &depth_texture);
+    glTextureStorage2D(depth_texture, 1, GL_DEPTH24_STENCIL8, width, height);
+    for (GLuint texture : textures) {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glTextureParameteri(depth_texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(depth_texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glCreateFramebuffers(1, &FBO);
+    GLenum draw_buffers[TARGETS];
+    for (int i = 0; i < TARGETS; i++) {
+        glNamedFramebufferTexture(FBO, GL_COLOR_ATTACHMENT0 + i, textures[i], 0);
+        draw_buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    glNamedFramebufferTexture(FBO, GL_DEPTH_STENCIL_ATTACHMENT, depth_texture, 0);
+    glNamedFramebufferDrawBuffers(FBO, TARGETS, draw_buffers);
+
+    if (glCheckNamedFramebufferStatus(FBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw std::runtime_error("G-buffer framebuffer is not complete.");
+    }
+}
+
+void DeferredRenderer::begin(int width, int height) {
+    if (FBO == 0 || width != this->width || height != this->height) {
+        create_targets(width, height);
+    }
+
+    const GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < TARGETS; i++) {
+        glClearNamedFramebufferfv(FBO, GL_COLOR, i, zero);
+    }
+    glClearNamedFramebufferfi(FBO, GL_DEPTH_STENCIL, 0, 1.0f, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+}
+
+void DeferredRenderer::resolve(const glm::mat4& view_matrix, const glm::mat4& projection_matrix, GLuint target) {
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+    // background pixels are discarded and keep the clear color
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+
+    static constexpr UniformName NAMES[TARGETS] = {
+        UniformName("g_albedo"), UniformName("g_normal"), UniformName("g_ambient"),
+        UniformName("g_diffuse"), UniformName("g_specular"),
+    };
+    static constexpr UniformName G_DEPTH{ "g_depth" };
+    static constexpr UniformName INV_P_M{ "inv_p_m" };
+    static constexpr UniformName INV_V_M{ "inv_v_m" };
+
+    resolve_shader->activate();
+    for (int i = 0; i < TARGETS; i++) {
+        glBindTextureUnit(i, textures[i]);
+        resolve_shader->uniform<int>(NAMES[i]).set(i);
+    }
+    glBindTextureUnit(TARGETS, depth_texture);
+    resolve_shader->uniform<int>(G_DEPTH).set(TARGETS);
+    resolve_shader->uniform<glm::mat4>(INV_P_M).set(glm::inverse(projection_matrix));
+    resolve_shader->uniform<glm::mat4>(INV_V_M).set(glm::inverse(view_matrix));
+    glBindVertexArray(empty_VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    for (int i = 0; i <= TARGETS; i++) {
+        glBindTextureUnit(i, 0);
+    }
+
+    // forward passes are depth tested against the deferred geometry
+    glBlitNamedFramebuffer(FBO, target, 0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+}
+
+void DeferredRenderer::delete_targets() {
+    if (FBO != 0) {
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteTextures(TARGETS, textures);
+        glDeleteTextures(1, &depth_texture);
+        FBO = depth_texture = 0;
+        for (GLuint& texture : textures) {
+            texture = 0;
+        }
+    }
+    width = height = 0;
+}
+
+void DeferredRenderer::clear() {
+    delete_targets();
+    if (empty_VAO != 0) {
+        glDeleteVertexArrays(1, &empty_VAO);
+        empty_VAO = 0;
+    }
+    resolve_shader = nullptr;
+}
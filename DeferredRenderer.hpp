@@ -0,0 +1,65 @@
+#ifndef DEFERREDRENDERER_HPP
+#define DEFERREDRENDERER_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "ShaderProgram.hpp"
+
+/* Deferred shading, alternative to the forward light loop of lighting.frag.
+ * Opaque geometry is drawn once into a G-buffer:
+ *   0: albedo (RGBA8), sampled from tex0
+ *   1: view space normal, shininess in w (RGBA16F)
+ *   2..4: ambient, diffuse and specular material (RGBA8)
+ *   depth (DEPTH24_STENCIL8, sampled to reconstruct the position)
+ * and a fullscreen pass lights every pixel once with the clustered light lists.
+ * Depth is copied to the target framebuffer afterwards, so the forward passes
+ * (instanced batches, cutouts, transparents, status bar) are drawn on top.
+ * Fragment shaders for the geometry pass write the five targets (see gbuffer.frag).
+ */
+class DeferredRenderer {
+public:
+    DeferredRenderer() = default;
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+    ~DeferredRenderer() { clear(); }
+
+    /* @param resolve_shader: oit_composite.vert + deferred_resolve.frag
+     */
+    void init(ShaderProgram& resolve_shader) {
+        clear();
+        this->resolve_shader = &resolve_shader;
+        glCreateVertexArrays(1, &empty_VAO);
+    }
+
+    /* Clear the G-buffer and bind it for the geometry pass
+     * @param width: framebuffer width
+     * @param height: framebuffer height
+     */
+    void begin(int width, int height);
+
+    /* Light the G-buffer into the target framebuffer and copy its depth there
+     * @param view_matrix: current view matrix
+     * @param projection_matrix: current projection matrix
+     * @param target: framebuffer to draw into, 0 = default framebuffer
+     */
+    void resolve(const glm::mat4& view_matrix, const glm::mat4& projection_matrix, GLuint target = 0);
+
+    void clear();
+
+private:
+    static constexpr int TARGETS = 5;
+
+    ShaderProgram* resolve_shader = nullptr;
+    GLuint FBO = 0;
+    GLuint textures[TARGETS] = {};
+    GLuint depth_texture = 0;
+    GLuint empty_VAO = 0; // fullscreen triangle is generated from gl_VertexID
+    int width = 0;
+    int height = 0;
+
+    void create_targets(int width, int height);
+    void delete_targets();
+};
+
+#endif // DEFERREDRENDERER_HPP
@@ -0,0 +1,64 @@
+#ifndef FRAMEUNIFORMS_HPP
+#define FRAMEUNIFORMS_HPP
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "RingBuffer.hpp"
+
+// per-frame data shared by all shader programs, std140 layout (uniform block "Frame" in shaders)
+struct FrameData {
+    glm::mat4 v_m;
+    glm::mat4 p_m;
+    glm::vec4 camera_position; // w unused
+    float time;
+    float padding[3];
+};
+
+/* Uniform block with camera matrices, written once per frame to the stream ring
+ * and bound to a fixed binding point, so shaders do not need per-model v_m/p_m uniforms.
+ */
+class FrameUniforms {
+public:
+    static constexpr GLuint BINDING = 0; // uniform block binding point
+
+    FrameUniforms() = default;
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+    ~FrameUniforms() { clear(); }
+
+    /* @param stream: ring the block is written to every frame
+     */
+    void init(RingBuffer& stream) {
+        clear();
+        this->stream = &stream;
+        // valid block for draws before the first frame (level load)
+        update(glm::mat4(1.0f), glm::mat4(1.0f), glm::vec3(0.0f), 0.0f);
+    }
+
+    /* Upload data for the current frame
+     * @param view_matrix: camera view matrix
+     * @param projection_matrix: camera projection matrix
+     * @param camera_position: camera position in world space
+     * @param time: time since start in seconds
+     */
+    void update(const glm::mat4& view_matrix, const glm::mat4& projection_matrix,
+                const glm::vec3& camera_position, float time) {
+        FrameData data{};
+        data.v_m = view_matrix;
+        data.p_m = projection_matrix;
+        data.camera_position = glm::vec4(camera_position, 1.0f);
+        data.time = time;
+        RingBuffer::Allocation block = stream->push(&data, sizeof(FrameData));
+        glBindBufferRange(GL_UNIFORM_BUFFER, BINDING, block.buffer, block.offset, block.size);
+    }
+
+    void clear() {
+        stream = nullptr;
+    }
+
+private:
+    RingBuffer* stream = nullptr;
+};
+
+#endif // FRAMEUNIFORMS_HPP
@@ -0,0 +1,55 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+
+/* View frustum as 6 planes extracted from the view-projection matrix
+ * (Gribb & Hartmann), plane normals point inside.
+ */
+class Frustum {
+public:
+    Frustum() = default;
+
+    /* @param view_projection: projection_matrix * view_matrix
+     */
+    explicit Frustum(const glm::mat4& view_projection) {
+        glm::mat4 m = glm::transpose(view_projection);
+        planes[0] = m[3] + m[0]; // left
+        planes[1] = m[3] - m[0]; // right
+        planes[2] = m[3] + m[1]; // bottom
+        planes[3] = m[3] - m[1]; // top
+        planes[4] = m[3] + m[2]; // near
+        planes[5] = m[3] - m[2]; // far
+        for (auto& plane : planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    /* Is the box at least partially inside?
+     * @param box: world space box
+     */
+    bool intersects(const AABB& box) const {
+        if (!box.valid()) {
+            return false;
+        }
+        for (const auto& plane : planes) {
+            // corner farthest along the plane normal
+            glm::vec3 p(plane.x > 0.0f ? box.max.x : box.min.x,
+                        plane.y > 0.0f ? box.max.y : box.min.y,
+                        plane.z > 0.0f ? box.max.z : box.min.z);
+            if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::array<glm::vec4, 6> planes;
+};
+
+#endif // FRUSTUM_HPP
@@ -0,0 +1,63 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/* 64-bit FNV-1a hash for cache keys stored on disk.
+ * Unlike std::hash the result is the same on every run and platform.
+ */
+class Hash {
+public:
+    void add(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            value = (value ^ bytes[i]) * PRIME;
+        }
+    }
+
+    void add(const std::string& text) {
+        add(text.data(), text.size());
+        // length separates "ab" + "c" from "a" + "bc"
+        add_value(text.size());
+    }
+
+    // plain values only (numbers, glm vectors), no pointers inside
+    template <typename T>
+    void add_value(const T& data) {
+        static_assert(std::is_trivially_copyable_v<T>, "Hash::add_value needs a trivially copyable type");
+        add(&data, sizeof(T));
+    }
+
+    uint64_t get() const { return value; }
+
+    // hash of a C string, usable at compile time (see UniformName)
+    static constexpr uint64_t of(const char* text) {
+        uint64_t result = OFFSET;
+        for (; *text != '\0'; ++text) {
+            result = (result ^ (unsigned char)*text) * PRIME;
+        }
+        return result;
+    }
+
+    std::string hex() const { return to_hex(value); }
+
+    // 16 hex digits, usable as a file name
+    static std::string to_hex(uint64_t value) {
+        static const char digits[] = "0123456789abcdef";
+        std::string text(16, '0');
+        for (int i = 0; i < 16; ++i) {
+            text[15 - i] = digits[(value >> (4 * i)) & 0xF];
+        }
+        return text;
+    }
+
+private:
+    static constexpr uint64_t OFFSET = 0xcbf29ce484222325ULL;
+    static constexpr uint64_t PRIME = 0x100000001b3ULL;
+    uint64_t value = OFFSET;
+};
+
+#endif // HASH_HPP
@@ -0,0 +1,226 @@
+#include "IndirectRenderer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+void IndirectRenderer::init(std::unordered_map<std::string, Model>& prototypes, ShaderProgram& shader,
+                            RingBuffer& stream) {
+    clear();
+    this->shader = &shader;
+    this->stream = &stream;
+
+    std::vector<Vertex> vertex_data;
+    std::vector<GLuint> index_data;
+    for (auto& [token, prototype] : prototypes) {
+        for (auto& mesh : prototype.meshes) {
+            const MeshBuffers* buffers = mesh.get_buffers().get();
+            if (buffers == nullptr || mesh_ranges.count(buffers)) {
+                continue;
+            }
+            MeshRange range;
+            range.first_index = (GLuint)index_data.size();
+            range.index_count = (GLuint)buffers->indices.size();
+            range.base_vertex = (GLint)vertex_data.size();
+            mesh_ranges[buffers] = range;
+
+            vertex_data.insert(vertex_data.end(), buffers->vertices.begin(), buffers->vertices.end());
+            index_data.insert(index_data.end(), buffers->indices.begin(), buffers->indices.end());
+        }
+    }
+
+    glCreateVertexArrays(1, &VAO);
+    glCreateBuffers(1, &VBO);
+    glCreateBuffers(1, &EBO);
+    glCreateBuffers(1, &command_buffer);
+    glCreateBuffers(1, &draw_data_buffer);
+
+    glNamedBufferStorage(VBO, vertex_data.size() * sizeof(Vertex), vertex_data.data(), 0);
+    glNamedBufferStorage(EBO, index_data.size() * sizeof(GLuint), index_data.data(), 0);
+
+    glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(Vertex));
+    glVertexArrayElementBuffer(VAO, EBO);
+
+    glEnableVertexArrayAttrib(VAO, 0);
+    glVertexArrayAttribFormat(VAO, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+    glVertexArrayAttribBinding(VAO, 0, 0);
+
+    glEnableVertexArrayAttrib(VAO, 1);
+    glVertexArrayAttribFormat(VAO, 1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
+    glVertexArrayAttribBinding(VAO, 1, 0);
+
+    glEnableVertexArrayAttrib(VAO, 2);
+    glVertexArrayAttribFormat(VAO, 2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords));
+    glVertexArrayAttribBinding(VAO, 2, 0);
+
+    // positions only, same indices and base vertices
+    std::vector<glm::vec3> position_data;
+    position_data.reserve(vertex_data.size());
+    for (const auto& vertex : vertex_data) {
+        position_data.push_back(vertex.Position);
+    }
+    glCreateVertexArrays(1, &depth_VAO);
+    glCreateBuffers(1, &position_VBO);
+    glNamedBufferStorage(position_VBO, position_data.size() * sizeof(glm::vec3), position_data.data(), 0);
+    glVertexArrayVertexBuffer(depth_VAO, 0, position_VBO, 0, sizeof(glm::vec3));
+    glVertexArrayElementBuffer(depth_VAO, EBO);
+    glEnableVertexArrayAttrib(depth_VAO, 0);
+    glVertexArrayAttribFormat(depth_VAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(depth_VAO, 0, 0);
+
+    std::cout << "Indirect renderer: " << mesh_ranges.size() << " meshes, " << vertex_data.size()
+              << " vertices in shared buffer." << std::endl;
+}
+
+DrawData IndirectRenderer::make_draw_data(const Model& model) {
+    const Mesh& mesh = model.meshes[0];
+    DrawData data;
+    data.model_matrix = model.local_model_matrix * model.compute_model_matrix();
+    data.ambient = glm::vec4(mesh.ambient_material, 1.0f);
+    data.diffuse = glm::vec4(mesh.diffuse_material, 1.0f);
+    data.specular = glm::vec4(mesh.specular_material, mesh.reflectivity);
+    data.layer = glm::ivec4(model.texture_layer, 0, 0, 0);
+    return data;
+}
+
+void IndirectRenderer::sync(const std::vector<std::unique_ptr<Model>>& models, unsigned version,
+                            bool skip_baked) {
+    if (VAO == 0) {
+        return;
+    }
+
+    if (!synced || version != synced_version || skip_baked != synced_skip_baked) {
+        // entities appeared or disappeared - rebuild commands, grouped by texture array
+        std::map<GLuint, std::vector<const Model*>> by_array;
+        for (const auto& model : models) {
+            if (accepts(*model, skip_baked) && mesh_ranges.count(model->meshes[0].get_buffers().get())) {
+                by_array[model->texture_array_id].push_back(model.get());
+            }
+        }
+
+        // moving entities take the first slots, so they are streamed as one block
+        size_t entity_count = 0;
+        GLuint next_static = 0;
+        for (const auto& [array_id, entities] : by_array) {
+            entity_count += entities.size();
+            next_static += (GLuint)std::count_if(entities.begin(), entities.end(),
+                                                 [](const Model* model) { return model->isDoor; });
+        }
+        GLuint next_dynamic = 0;
+
+        std::vector<DrawElementsIndirectCommand> command_data;
+        std::vector<DrawData> draw_data(entity_count);
+        groups.clear();
+        dynamics.clear();
+        dynamic_data.clear();
+        for (auto& [array_id, entities] : by_array) {
+            Group group;
+            group.texture_array_id = array_id;
+            group.first_command = (GLsizei)command_data.size();
+            for (const Model* model : entities) {
+                const MeshRange& range = mesh_ranges[model->meshes[0].get_buffers().get()];
+                GLuint slot = model->isDoor ? next_dynamic++ : next_static++;
+
+                DrawElementsIndirectCommand command;
+                command.count = range.index_count;
+                command.instanceCount = 1;
+                command.firstIndex = range.first_index;
+                command.baseVertex = range.base_vertex;
+                command.baseInstance = slot;
+                command_data.push_back(command);
+                draw_data[slot] = make_draw_data(*model);
+
+                if (model->isDoor) {
+                    dynamics.push_back(model);
+                }
+            }
+            group.command_count = (GLsizei)command_data.size() - group.first_command;
+            groups.push_back(group);
+        }
+        dynamic_data.assign(draw_data.begin(), draw_data.begin() + dynamics.size());
+
+        glNamedBufferData(command_buffer, command_data.size() * sizeof(DrawElementsIndirectCommand),
+                          command_data.data(), GL_STATIC_DRAW);
+        glNamedBufferData(draw_data_buffer, draw_data.size() * sizeof(DrawData), draw_data.data(),
+                          GL_DYNAMIC_DRAW);
+
+        commands = (int)command_data.size();
+        rebuilds++;
+        synced = true;
+        synced_version = version;
+        synced_skip_baked = skip_baked;
+        return;
+    }
+
+    // same entities - only moving ones get new transformation, copied on the GPU from the ring
+    if (dynamics.empty()) {
+        return;
+    }
+    for (size_t slot = 0; slot < dynamics.size(); ++slot) {
+        dynamic_data[slot].model_matrix = dynamics[slot]->local_model_matrix * dynamics[slot]->compute_model_matrix();
+    }
+    RingBuffer::Allocation block = stream->push(dynamic_data.data(), dynamic_data.size() * sizeof(DrawData));
+    glCopyNamedBufferSubData(block.buffer, draw_data_buffer, block.offset, 0, block.size);
+}
+
+void IndirectRenderer::draw(ShaderProgram* shader_override) {
+    draw_calls = 0;
+    if (VAO == 0 || groups.empty()) {
+        return;
+    }
+    ShaderProgram* shader = shader_override ? shader_override : this->shader;
+    shader->activate();
+    shader->common().tex0.set(0);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, draw_data_buffer);
+    glActiveTexture(GL_TEXTURE0);
+
+    for (const auto& group : groups) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, group.texture_array_id);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                    (void*)(group.first_command * sizeof(DrawElementsIndirectCommand)),
+                                    group.command_count, 0);
+        draw_calls++;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void IndirectRenderer::draw_depth(ShaderProgram& depth_shader) {
+    if (VAO == 0 || commands == 0) {
+        return;
+    }
+    depth_shader.activate();
+
+    // texture arrays do not matter for depth, groups are consecutive in the command buffer
+    glBindVertexArray(depth_VAO);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, draw_data_buffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, commands, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void IndirectRenderer::clear() {
+    if (VAO != 0) {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteVertexArrays(1, &depth_VAO);
+        glDeleteBuffers(1, &position_VBO);
+        glDeleteBuffers(1, &command_buffer);
+        glDeleteBuffers(1, &draw_data_buffer);
+    }
+    VAO = VBO = EBO = depth_VAO = position_VBO = command_buffer = draw_data_buffer = 0;
+    mesh_ranges.clear();
+    groups.clear();
+    dynamics.clear();
+    dynamic_data.clear();
+    stream = nullptr;
+    synced = false;
+    commands = 0;
+}
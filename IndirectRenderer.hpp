@@ -0,0 +1,127 @@
+#ifndef INDIRECTRENDERER_HPP
+#define INDIRECTRENDERER_HPP
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "MeshBuffers.hpp"
+#include "Model.hpp"
+#include "RingBuffer.hpp"
+#include "ShaderProgram.hpp"
+
+// layout of one glMultiDrawElementsIndirect command (see https://docs.gl/gl4/glMultiDrawElementsIndirect)
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance; // index to DrawData, read as gl_BaseInstance
+};
+
+// per-draw data in the SSBO, std430 layout (see lighting_indirect.vert)
+struct DrawData {
+    glm::mat4 model_matrix;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;  // a = shininess
+    glm::ivec4 layer;    // x = texture array layer
+};
+
+/* GPU driven renderer: meshes of all prototypes live in one shared vertex/index buffer,
+ * every entity is one DrawElementsIndirectCommand and all entities sharing a texture
+ * array are drawn with a single glMultiDrawElementsIndirect.
+ * Commands are rebuilt only when entities appear or disappear (see sync()),
+ * moving entities (doors) take the first DrawData slots, which are written to the stream
+ * ring every frame and copied into the SSBO on the GPU.
+ */
+class IndirectRenderer {
+public:
+    static constexpr GLuint DRAW_DATA_BINDING = 0; // SSBO binding point
+
+    // statistics
+    int draw_calls = 0;
+    int commands = 0;
+    int rebuilds = 0;
+
+    IndirectRenderer() = default;
+    IndirectRenderer(const IndirectRenderer&) = delete;
+    IndirectRenderer& operator=(const IndirectRenderer&) = delete;
+    ~IndirectRenderer() { clear(); }
+
+    /* Entities drawn by this renderer: opaque, lit and textured from a texture array
+     * @param model: scene model
+     * @param skip_baked: baked walls are drawn by StaticLevelMesh
+     */
+    static bool accepts(const Model& model, bool skip_baked) {
+        return !model.transparent && !model.isSprite && model.texture_array_id != 0 &&
+               !(model.baked && skip_baked);
+    }
+
+    /* Upload meshes of all prototypes into the shared vertex/index buffer
+     * @param prototypes: token -> prototype model
+     * @param shader: program reading DrawData (lighting_indirect.vert)
+     * @param stream: ring the DrawData of moving entities is written to every frame
+     */
+    void init(std::unordered_map<std::string, Model>& prototypes, ShaderProgram& shader, RingBuffer& stream);
+
+    /* Rebuild command buffer if the scene changed, update moving entities
+     * @param models: all scene models
+     * @param version: incremented by the caller whenever models are added or removed
+     * @param skip_baked: see accepts()
+     */
+    void sync(const std::vector<std::unique_ptr<Model>>& models, unsigned version, bool skip_baked);
+
+    /* One glMultiDrawElementsIndirect per texture array.
+     * Light uniforms have to be set by the caller.
+     * @param shader_override: program reading DrawData used instead of the lit one (G-buffer pass)
+     */
+    void draw(ShaderProgram* shader_override = nullptr);
+
+    /* All commands in one glMultiDrawElementsIndirect from the position-only stream
+     * @param depth_shader: program reading DrawData (depth_indirect.vert)
+     */
+    void draw_depth(ShaderProgram& depth_shader);
+
+    void clear();
+
+    ShaderProgram* get_shader() const { return shader; }
+
+private:
+    // offsets of one prototype mesh in the shared buffers
+    struct MeshRange {
+        GLuint first_index{ 0 };
+        GLuint index_count{ 0 };
+        GLint base_vertex{ 0 };
+    };
+    // commands drawn with one texture array
+    struct Group {
+        GLuint texture_array_id{ 0 };
+        GLsizei first_command{ 0 };
+        GLsizei command_count{ 0 };
+    };
+    ShaderProgram* shader = nullptr;
+    RingBuffer* stream = nullptr;
+    GLuint VAO{ 0 };
+    GLuint VBO{ 0 };
+    GLuint EBO{ 0 };
+    GLuint depth_VAO{ 0 };    // position-only stream for the depth pre-pass
+    GLuint position_VBO{ 0 };
+    GLuint command_buffer{ 0 };
+    GLuint draw_data_buffer{ 0 };
+
+    std::unordered_map<const MeshBuffers*, MeshRange> mesh_ranges;
+    std::vector<Group> groups;
+    std::vector<const Model*> dynamics; // moving entities, slot = index
+    std::vector<DrawData> dynamic_data; // their DrawData, streamed every frame
+    unsigned synced_version = 0;
+    bool synced_skip_baked = false;
+    bool synced = false;
+
+    static DrawData make_draw_data(const Model& model);
+};
+
+#endif // INDIRECTRENDERER_HPP
@@ -0,0 +1,126 @@
+#include "InstancedRenderer.hpp"
+
+#include <iostream>
+
+void InstancedRenderer::submit(const Model& model, const glm::mat4& model_matrix) {
+    const Mesh& mesh = model.meshes[0];
+    bool array = uses_texture_array(model);
+
+    // models of all tokens packed in one texture array (and sharing the mesh) form one batch
+    std::string key = array ? "texture_array " + std::to_string(model.texture_array_id) + " mesh " +
+                                  std::to_string(mesh.get_buffers()->VAO)
+                            : model.token;
+
+    Batch& batch = batches[key];
+    if (batch.VAO == 0 || batch.mesh != mesh.get_buffers()) {
+        // first use of the key (or a new level reloaded the mesh)
+        if (batch.VAO != 0) {
+            glDeleteVertexArrays(1, &batch.VAO);
+        }
+        batch.mesh = mesh.get_buffers();
+        if (array) {
+            batch.shader = lit_array_shader;
+            batch.texture_target = GL_TEXTURE_2D_ARRAY;
+        } else {
+            batch.shader = model.isSprite ? unlit_shader : lit_shader;
+            batch.texture_target = GL_TEXTURE_2D;
+        }
+        create_batch_buffers(batch);
+    }
+    batch.texture_id = array ? model.texture_array_id : model.texture_id;
+
+    InstanceData instance;
+    instance.model_matrix = model.local_model_matrix * model_matrix;
+    instance.ambient = glm::vec4(mesh.ambient_material, 1.0f);
+    instance.diffuse = glm::vec4(mesh.diffuse_material, 1.0f);
+    instance.specular = glm::vec4(mesh.specular_material, mesh.reflectivity);
+    instance.layer = array ? model.texture_layer : 0;
+    batch.instances.push_back(instance);
+}
+
+void InstancedRenderer::flush() {
+    draw_calls = 0;
+    instances = 0;
+
+    for (auto& [key, batch] : batches) {
+        if (batch.instances.empty()) {
+            continue;
+        }
+        ShaderProgram& shader = *batch.shader;
+        shader.activate();
+
+        // no re-specification, the ring region of this frame is not read by the GPU
+        RingBuffer::Allocation instance_data =
+            stream->push(batch.instances.data(), batch.instances.size() * sizeof(InstanceData));
+        glVertexArrayVertexBuffer(batch.VAO, 1, instance_data.buffer, instance_data.offset, sizeof(InstanceData));
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(batch.texture_target, batch.texture_id);
+        shader.common().tex0.set(0);
+
+        glBindVertexArray(batch.VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)batch.mesh->indices.size(), GL_UNSIGNED_INT,
+                                0, (GLsizei)batch.instances.size());
+
+        draw_calls++;
+        instances += (int)batch.instances.size();
+        batch.instances.clear();
+    }
+    glBindVertexArray(0);
+}
+
+void InstancedRenderer::clear() {
+    for (auto& [key, batch] : batches) {
+        if (batch.VAO != 0) {
+            glDeleteVertexArrays(1, &batch.VAO);
+        }
+    }
+    batches.clear();
+}
+
+void InstancedRenderer::create_batch_buffers(Batch& batch) {
+    glCreateVertexArrays(1, &batch.VAO);
+
+    // binding 0: shared mesh vertices
+    glVertexArrayVertexBuffer(batch.VAO, 0, batch.mesh->VBO, 0, sizeof(Vertex));
+    glVertexArrayElementBuffer(batch.VAO, batch.mesh->EBO);
+
+    glEnableVertexArrayAttrib(batch.VAO, 0);
+    glVertexArrayAttribFormat(batch.VAO, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+    glVertexArrayAttribBinding(batch.VAO, 0, 0);
+
+    glEnableVertexArrayAttrib(batch.VAO, 1);
+    glVertexArrayAttribFormat(batch.VAO, 1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
+    glVertexArrayAttribBinding(batch.VAO, 1, 0);
+
+    glEnableVertexArrayAttrib(batch.VAO, 2);
+    glVertexArrayAttribFormat(batch.VAO, 2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords));
+    glVertexArrayAttribBinding(batch.VAO, 2, 0);
+
+    // binding 1: per-instance data, buffer range from the ring is set in flush()
+    glVertexArrayBindingDivisor(batch.VAO, 1, 1);
+
+    // mat4 takes 4 consecutive locations
+    for (GLuint column = 0; column < 4; ++column) {
+        glEnableVertexArrayAttrib(batch.VAO, 3 + column);
+        glVertexArrayAttribFormat(batch.VAO, 3 + column, 4, GL_FLOAT, GL_FALSE,
+                                  offsetof(InstanceData, model_matrix) + column * sizeof(glm::vec4));
+        glVertexArrayAttribBinding(batch.VAO, 3 + column, 1);
+    }
+
+    glEnableVertexArrayAttrib(batch.VAO, 7);
+    glVertexArrayAttribFormat(batch.VAO, 7, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, ambient));
+    glVertexArrayAttribBinding(batch.VAO, 7, 1);
+
+    glEnableVertexArrayAttrib(batch.VAO, 8);
+    glVertexArrayAttribFormat(batch.VAO, 8, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, diffuse));
+    glVertexArrayAttribBinding(batch.VAO, 8, 1);
+
+    glEnableVertexArrayAttrib(batch.VAO, 9);
+    glVertexArrayAttribFormat(batch.VAO, 9, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, specular));
+    glVertexArrayAttribBinding(batch.VAO, 9, 1);
+
+    glEnableVertexArrayAttrib(batch.VAO, 10);
+    glVertexArrayAttribIFormat(batch.VAO, 10, 1, GL_INT, offsetof(InstanceData, layer));
+    glVertexArrayAttribBinding(batch.VAO, 10, 1);
+}
@@ -0,0 +1,99 @@
+#ifndef INSTANCEDRENDERER_HPP
+#define INSTANCEDRENDERER_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "MeshBuffers.hpp"
+#include "Model.hpp"
+#include "RingBuffer.hpp"
+#include "ShaderProgram.hpp"
+
+/* Per-instance data, read by the *_instanced.vert shaders
+ * from vertex attributes with divisor 1.
+ */
+struct InstanceData {
+    glm::mat4 model_matrix;   // locations 3-6
+    glm::vec4 ambient;        // location 7, rgb = ambient material
+    glm::vec4 diffuse;        // location 8, rgb = diffuse material
+    glm::vec4 specular;       // location 9, rgb = specular material, a = shininess
+    GLint layer;              // location 10, layer in the texture array (array batches only)
+};
+
+/* Groups models sharing a prototype (same map token) and draws each group
+ * with a single glDrawElementsInstanced call. Lit models whose texture is packed
+ * in a texture array are grouped by the array instead, so all wall types
+ * end up in one draw.
+ * Usage per frame: submit() all models, then flush().
+ */
+class InstancedRenderer {
+public:
+    // statistics of the last flush()
+    int draw_calls = 0;
+    int instances = 0;
+
+    InstancedRenderer() = default;
+    InstancedRenderer(const InstancedRenderer&) = delete;
+    InstancedRenderer& operator=(const InstancedRenderer&) = delete;
+    ~InstancedRenderer() { clear(); }
+
+    /* Set shader programs used for lit (walls, doors...) and unlit (sprites) batches.
+     * All programs have to read per-instance attributes (see InstanceData),
+     * lit_array_shader samples sampler2DArray tex0 with the instance layer.
+     * Instance data of every frame is written to the stream ring.
+     * @param texture_arrays: group by texture array, false = every batch samples the model's own texture
+     */
+    void init(ShaderProgram& lit_shader, ShaderProgram& lit_array_shader, ShaderProgram& unlit_shader,
+              RingBuffer& stream, bool texture_arrays = true) {
+        this->lit_shader = &lit_shader;
+        this->lit_array_shader = &lit_array_shader;
+        this->unlit_shader = &unlit_shader;
+        this->stream = &stream;
+        this->texture_arrays = texture_arrays;
+    }
+
+    /* Add model to the batch of its prototype
+     * @param model: model with non-empty token
+     * @param model_matrix: complete model matrix of this instance
+     */
+    void submit(const Model& model, const glm::mat4& model_matrix);
+
+    /* Upload instance data and draw all non-empty batches.
+     * Light uniforms have to be set by the caller.
+     */
+    void flush();
+
+    /* Delete all batches and their GPU buffers */
+    void clear();
+
+private:
+    struct Batch {
+        std::shared_ptr<MeshBuffers> mesh; // keeps mesh alive while batch exists
+        GLuint texture_id{ 0 };
+        GLenum texture_target{ GL_TEXTURE_2D }; // GL_TEXTURE_2D_ARRAY for array batches
+        ShaderProgram* shader = nullptr;
+        GLuint VAO{ 0 };
+        std::vector<InstanceData> instances;
+    };
+
+    ShaderProgram* lit_shader = nullptr;
+    ShaderProgram* lit_array_shader = nullptr;
+    ShaderProgram* unlit_shader = nullptr;
+    RingBuffer* stream = nullptr;
+    bool texture_arrays = true;
+    // batch key (map token or texture array) -> batch
+    // batches live across frames, only instances are cleared
+    std::unordered_map<std::string, Batch> batches;
+
+    void create_batch_buffers(Batch& batch);
+    bool uses_texture_array(const Model& model) const {
+        return texture_arrays && model.texture_array_id != 0 && !model.isSprite;
+    }
+};
+
+#endif // INSTANCEDRENDERER_HPP
@@ -0,0 +1,92 @@
+#ifndef LIGHTBUFFER_HPP
+#define LIGHTBUFFER_HPP
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Light.hpp"
+
+// one light in the SSBO, std430 layout (see struct Light in lighting.frag)
+struct LightData {
+    glm::vec4 position; // world space, w = 1 if active
+    glm::vec4 ambient;  // w = range, see LightBuffer::light_range
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+};
+
+/* Shader storage buffer with all lights of the level and their count.
+ * Uploaded only when lights change, shaders loop over light_count.
+ */
+class LightBuffer {
+public:
+    static constexpr GLuint BINDING = 1; // SSBO binding point
+    // contribution under which a light is ignored, defines its range
+    static constexpr float LIGHT_CUTOFF = 1.0f / 64.0f;
+
+    /* Distance at which the light contributes less than LIGHT_CUTOFF
+     * (inverse of the attenuation in lighting.frag: 1 / (1 + 0.09 d + 0.032 d^2))
+     * @param light: light source
+     * @return: range in world units
+     */
+    static float light_range(const Light& light) {
+        float intensity = glm::max(glm::max(glm::max(light.ambient.r, light.ambient.g), light.ambient.b),
+                                   glm::max(glm::max(light.diffuse.r, light.diffuse.g), light.diffuse.b));
+        intensity = glm::max(intensity, glm::max(glm::max(light.specular.r, light.specular.g), light.specular.b));
+        if (intensity <= LIGHT_CUTOFF) {
+            return 0.0f;
+        }
+        const float a = 0.032f, b = 0.09f;
+        float c = 1.0f - intensity / LIGHT_CUTOFF;
+        return (-b + glm::sqrt(b * b - 4.0f * a * c)) / (2.0f * a);
+    }
+
+    LightBuffer() = default;
+    LightBuffer(const LightBuffer&) = delete;
+    LightBuffer& operator=(const LightBuffer&) = delete;
+    ~LightBuffer() { clear(); }
+
+    /* Upload lights and bind the buffer
+     * @param lights: lights of the level
+     */
+    void upload(const std::vector<Light>& lights) {
+        std::vector<LightData> data(lights.size());
+        for (size_t i = 0; i < lights.size(); ++i) {
+            const Light& light = lights[i];
+            data[i].position = glm::vec4(light.position, light.isActive ? 1.0f : 0.0f);
+            data[i].ambient = glm::vec4(light.ambient, light_range(light));
+            data[i].diffuse = glm::vec4(light.diffuse, 0.0f);
+            data[i].specular = glm::vec4(light.specular, 0.0f);
+        }
+
+        if (SSBO == 0) {
+            glCreateBuffers(1, &SSBO);
+        }
+        // header (light_count padded to 16 bytes) followed by the array
+        GLuint header[4] = { (GLuint)lights.size(), 0, 0, 0 };
+        glNamedBufferData(SSBO, sizeof(header) + data.size() * sizeof(LightData), nullptr, GL_DYNAMIC_DRAW);
+        glNamedBufferSubData(SSBO, 0, sizeof(header), header);
+        if (!data.empty()) {
+            glNamedBufferSubData(SSBO, sizeof(header), data.size() * sizeof(LightData), data.data());
+        }
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, SSBO);
+        count = (int)lights.size();
+    }
+
+    int size() const { return count; }
+
+    void clear() {
+        if (SSBO != 0) {
+            glDeleteBuffers(1, &SSBO);
+            SSBO = 0;
+        }
+        count = 0;
+    }
+
+private:
+    GLuint SSBO{ 0 };
+    int count = 0;
+};
+
+#endif // LIGHTBUFFER_HPP
@@ -0,0 +1,211 @@
+#include "LightVisibility.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "LightBuffer.hpp"
+#include "StaticLevelMesh.hpp"
+
+void LightVisibility::build(Map& map, std::unordered_map<std::string, Model>& prototypes,
+                            const std::vector<std::unique_ptr<Model>>& models, const std::vector<Light>& lights,
+                            const glm::vec3& offset) {
+    clear();
+    cols = map.getCols();
+    rows = map.getRows();
+    // tile (i, j) is centered at (i, 0, j) + offset
+    origin = glm::vec2(offset.x, offset.z) - 0.5f;
+
+    walls.assign(cols * rows, 0);
+    for (int j = 0; j < rows; j++) {
+        for (int i = 0; i < cols; i++) {
+            auto it = prototypes.find(std::string(1, map.fetchMapValue(i, j)));
+            if (it != prototypes.end() && StaticLevelMesh::is_static(it->second)) {
+                walls[j * cols + i] = 1;
+            }
+        }
+    }
+
+    door_at.assign(cols * rows, -1);
+    for (const auto& model : models) {
+        const Door* door = dynamic_cast<const Door*>(model.get());
+        if (door != nullptr) {
+            glm::ivec2 tile = glm::ivec2(glm::floor(glm::vec2(door->origin.x, door->origin.z) - origin));
+            if (tile.x < 0 || tile.y < 0 || tile.x >= cols || tile.y >= rows) {
+                continue;
+            }
+            door_at[tile.y * cols + tile.x] = (int)doors.size();
+            doors.push_back({ door, tile, door_blocking(*door) });
+        }
+    }
+
+    for (const auto& light : lights) {
+        LightInfo info;
+        info.position = light.position;
+        info.range = light.isActive ? LightBuffer::light_range(light) : 0.0f;
+        info.occludable = light.position.y <= WALL_TOP;
+        this->lights.push_back(info);
+    }
+
+    words_per_tile = glm::max(1, (int)(lights.size() + 31) / 32);
+    bits.assign((size_t)cols * rows * words_per_tile, 0);
+
+    int min_row = rows, max_row = -1;
+    for (size_t l = 0; l < this->lights.size(); ++l) {
+        bake_light(l, min_row, max_row);
+    }
+
+    glCreateBuffers(1, &SSBO);
+    glNamedBufferData(SSBO, sizeof(Header) + bits.size() * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+    upload_header();
+    upload_rows(0, rows - 1);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, SSBO);
+
+    std::cout << "Light visibility baked: " << this->lights.size() << " lights, " << rays << " rays."
+              << std::endl;
+}
+
+void LightVisibility::update(bool enabled) {
+    if (SSBO == 0) {
+        return;
+    }
+    if (enabled != this->enabled) {
+        this->enabled = enabled;
+        upload_header();
+    }
+
+    // doors starting to open or finishing to close change what lights can reach
+    int min_row = rows, max_row = -1;
+    for (auto& tracked : doors) {
+        bool now_blocking = door_blocking(*tracked.door);
+        if (now_blocking == tracked.blocking) {
+            continue;
+        }
+        tracked.blocking = now_blocking;
+
+        glm::vec2 door_center = origin + glm::vec2(tracked.tile) + 0.5f;
+        for (size_t l = 0; l < lights.size(); ++l) {
+            const LightInfo& light = lights[l];
+            // the door can only matter for lights whose range covers it
+            if (light.occludable &&
+                glm::distance(glm::vec2(light.position.x, light.position.z), door_center) <= light.range + 1.0f) {
+                bake_light(l, min_row, max_row);
+            }
+        }
+        rebakes++;
+    }
+    if (min_row <= max_row) {
+        upload_rows(min_row, max_row);
+    }
+}
+
+bool LightVisibility::blocking(int x, int y) const {
+    if (x < 0 || y < 0 || x >= cols || y >= rows) {
+        return true;
+    }
+    if (walls[y * cols + x]) {
+        return true;
+    }
+    int door = door_at[y * cols + x];
+    return door >= 0 && doors[door].blocking;
+}
+
+bool LightVisibility::trace(glm::vec2 from, glm::ivec2 to) {
+    rays++;
+    glm::vec2 target = glm::vec2(to) + 0.5f;
+    glm::vec2 direction = target - from;
+    glm::ivec2 cell = glm::ivec2(glm::floor(from));
+    glm::ivec2 step = glm::ivec2(direction.x > 0.0f ? 1 : -1, direction.y > 0.0f ? 1 : -1);
+
+    // parametric distance to the next cell boundary and between boundaries (Amanatides & Woo)
+    glm::vec2 t_delta, t_max;
+    for (int axis = 0; axis < 2; ++axis) {
+        if (direction[axis] == 0.0f) {
+            t_delta[axis] = INFINITY;
+            t_max[axis] = INFINITY;
+        } else {
+            t_delta[axis] = std::abs(1.0f / direction[axis]);
+            float boundary = step[axis] > 0 ? cell[axis] + 1.0f : (float)cell[axis];
+            t_max[axis] = (boundary - from[axis]) / direction[axis];
+        }
+    }
+
+    while (cell != to) {
+        if (t_max.x < t_max.y) {
+            cell.x += step.x;
+            t_max.x += t_delta.x;
+        } else {
+            cell.y += step.y;
+            t_max.y += t_delta.y;
+        }
+        if (t_max.x > 1.0f && t_max.y > 1.0f && cell != to) {
+            // rounding - left the segment without reaching the target
+            break;
+        }
+        if (cell != to && blocking(cell.x, cell.y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LightVisibility::bake_light(size_t light, int& min_row, int& max_row) {
+    const LightInfo& info = lights[light];
+    GLuint mask = 1u << (light % 32);
+    size_t word = light / 32;
+
+    glm::vec2 position = glm::vec2(info.position.x, info.position.z) - origin;
+    int x0 = glm::max(0, (int)std::floor(position.x - info.range));
+    int x1 = glm::min(cols - 1, (int)std::floor(position.x + info.range));
+    int y0 = glm::max(0, (int)std::floor(position.y - info.range));
+    int y1 = glm::min(rows - 1, (int)std::floor(position.y + info.range));
+
+    // clear old bits in the whole range, tiles outside of it are never set
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            GLuint& bits_word = bits[((size_t)y * cols + x) * words_per_tile + word];
+            bits_word &= ~mask;
+
+            glm::vec3 tile_center = glm::vec3(origin.x + x + 0.5f, 0.0f, origin.y + y + 0.5f);
+            if (info.range <= 0.0f || glm::distance(info.position, tile_center) > info.range + 1.0f) {
+                continue;
+            }
+            if (!info.occludable || trace(position, glm::ivec2(x, y))) {
+                bits_word |= mask;
+            }
+        }
+    }
+    if (y0 <= y1) {
+        min_row = glm::min(min_row, y0);
+        max_row = glm::max(max_row, y1);
+    }
+}
+
+void LightVisibility::upload_header() {
+    Header header;
+    header.grid = glm::ivec4(cols, rows, words_per_tile, enabled ? 1 : 0);
+    header.origin = glm::vec4(origin, 0.0f, 0.0f);
+    glNamedBufferSubData(SSBO, 0, sizeof(Header), &header);
+}
+
+void LightVisibility::upload_rows(int first, int last) {
+    size_t row_words = (size_t)cols * words_per_tile;
+    glNamedBufferSubData(SSBO, sizeof(Header) + first * row_words * sizeof(GLuint),
+                         (last - first + 1) * row_words * sizeof(GLuint), bits.data() + first * row_words);
+}
+
+void LightVisibility::clear() {
+    if (SSBO != 0) {
+        glDeleteBuffers(1, &SSBO);
+        SSBO = 0;
+    }
+    walls.clear();
+    door_at.clear();
+    doors.clear();
+    lights.clear();
+    bits.clear();
+    cols = rows = words_per_tile = 0;
+    enabled = false;
+    rays = 0;
+    rebakes = 0;
+}
@@ -0,0 +1,103 @@
+#ifndef LIGHTVISIBILITY_HPP
+#define LIGHTVISIBILITY_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Door.hpp"
+#include "Light.hpp"
+#include "Map.hpp"
+#include "Model.hpp"
+
+/* Precomputed light visibility per map tile.
+ * At level load a 2D DDA is traced through the wall grid from every light to every tile
+ * in its range; the result is a bitmask of lights reaching each tile, stored in an SSBO.
+ * Lighting shaders skip lights whose bit is not set for the fragment's tile.
+ * Lights above the walls (y > WALL_TOP) are never occluded.
+ * When a door starts or stops blocking, only lights whose range covers the door are re-traced.
+ */
+class LightVisibility {
+public:
+    static constexpr GLuint BINDING = 4; // SSBO binding point
+    static constexpr float WALL_TOP = 0.5f;
+
+    // statistics
+    int rays = 0;
+    int rebakes = 0;
+
+    LightVisibility() = default;
+    LightVisibility(const LightVisibility&) = delete;
+    LightVisibility& operator=(const LightVisibility&) = delete;
+    ~LightVisibility() { clear(); }
+
+    /* Bake visibility of all lights for a new level
+     * @param map: level map
+     * @param prototypes: token -> prototype model
+     * @param models: scene models (doors are taken from here)
+     * @param lights: lights of the level (same order as in LightBuffer)
+     * @param offset: map to world offset (same as used for placing models)
+     */
+    void build(Map& map, std::unordered_map<std::string, Model>& prototypes,
+               const std::vector<std::unique_ptr<Model>>& models, const std::vector<Light>& lights,
+               const glm::vec3& offset);
+
+    /* Per frame: re-bake lights around doors that changed, upload enabled state
+     * @param enabled: false = shaders ignore visibility
+     */
+    void update(bool enabled);
+
+    void clear();
+
+private:
+    // header of the SSBO, std430 layout (see TileLights in lighting.frag)
+    struct Header {
+        glm::ivec4 grid;   // cols, rows, words per tile, enabled
+        glm::vec4 origin;  // xy = world xz of the tile (0, 0) corner
+    };
+    struct TrackedDoor {
+        const Door* door;
+        glm::ivec2 tile;
+        bool blocking;
+    };
+    struct LightInfo {
+        glm::vec3 position;
+        float range;
+        bool occludable;
+    };
+
+    GLuint SSBO{ 0 };
+    int cols = 0;
+    int rows = 0;
+    int words_per_tile = 0;
+    glm::vec2 origin{ 0.0f };
+    bool enabled = false;
+
+    std::vector<char> walls; // static blockers per tile
+    std::vector<int> door_at; // index to doors per tile, -1 if none
+    std::vector<TrackedDoor> doors;
+    std::vector<LightInfo> lights;
+    std::vector<GLuint> bits; // words_per_tile words per tile
+
+    bool blocking(int x, int y) const;
+    bool door_blocking(const Door& door) const { return door.state != DoorState::Opened; }
+
+    /* Walk the grid from a point to the center of a tile
+     * @return: true if no blocking tile lies between them
+     */
+    bool trace(glm::vec2 from, glm::ivec2 to);
+
+    /* Recompute bits of one light in all tiles of its range
+     * @param min_row, max_row: extended by the rows touched
+     */
+    void bake_light(size_t light, int& min_row, int& max_row);
+
+    void upload_header();
+    void upload_rows(int first, int last);
+};
+
+#endif // LIGHTVISIBILITY_HPP
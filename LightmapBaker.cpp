@@ -0,0 +1,282 @@
+#include "LightmapBaker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+#include "Hash.hpp"
+#include "LightBuffer.hpp"
+#include "LightVisibility.hpp"
+
+namespace {
+    // cache file header
+    constexpr uint32_t CACHE_MAGIC = 0x50414D4C; // "LMAP"
+    constexpr uint32_t CACHE_VERSION = 1;
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        int32_t width;
+        int32_t height;
+    };
+}
+
+void LightmapBaker::build(const std::string& level_file, Map& map,
+                          std::unordered_map<std::string, Model>& prototypes, StaticLevelMesh& level,
+                          const std::vector<Light>& lights, const glm::vec3& offset) {
+    clear();
+    const auto& buffers = level.get_buffers();
+    if (!buffers) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    cols = map.getCols();
+    rows = map.getRows();
+    // tile (i, j) is centered at (i, 0, j) + offset
+    origin = glm::vec2(offset.x, offset.z) - 0.5f;
+    walls.assign(cols * rows, 0);
+    for (int j = 0; j < rows; j++) {
+        for (int i = 0; i < cols; i++) {
+            auto it = prototypes.find(std::string(1, map.fetchMapValue(i, j)));
+            if (it != prototypes.end() && StaticLevelMesh::is_static(it->second)) {
+                walls[j * cols + i] = 1;
+            }
+        }
+    }
+    for (const auto& light : lights) {
+        float range = light.isActive ? LightBuffer::light_range(light) : 0.0f;
+        if (range > 0.0f) {
+            this->lights.push_back({ light.position, light.ambient, light.diffuse, range });
+        }
+    }
+
+    // atlas of square cells, one per triangle
+    const std::vector<Vertex>& vertices = buffers->vertices;
+    triangles = (int)(vertices.size() / 3);
+    int cells_per_row = glm::max(1, (int)std::ceil(std::sqrt((double)triangles)));
+    width = cells_per_row * CELL;
+    height = glm::max(1, (triangles + cells_per_row - 1) / cells_per_row) * CELL;
+
+    // texel centers of a cell land exactly on the triangle corners (see bake_triangle)
+    std::vector<glm::vec2> uvs(vertices.size());
+    for (int t = 0; t < triangles; ++t) {
+        glm::vec2 corner = glm::vec2((t % cells_per_row) * CELL, (t / cells_per_row) * CELL) + 0.5f;
+        glm::vec2 size = glm::vec2(width, height);
+        uvs[3 * t + 0] = corner / size;
+        uvs[3 * t + 1] = (corner + glm::vec2(CELL - 1, 0)) / size;
+        uvs[3 * t + 2] = (corner + glm::vec2(0, CELL - 1)) / size;
+    }
+    level.set_lightmap_uvs(uvs);
+
+    // everything the texels depend on
+    Hash hash;
+    std::ifstream file(level_file, std::ios::binary);
+    hash.add(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+    hash.add_value(CELL);
+    hash.add_value(LightVisibility::WALL_TOP);
+    hash.add_value(offset);
+    for (const auto& light : this->lights) {
+        hash.add_value(light);
+    }
+    hash.add(vertices.data(), vertices.size() * sizeof(Vertex));
+    for (const auto& section : level.get_sections()) {
+        hash.add_value(section.ambient_material);
+        hash.add_value(section.diffuse_material);
+        hash.add_value(section.first_index);
+        hash.add_value(section.index_count);
+    }
+
+    std::vector<glm::vec3> texels;
+    from_cache = load_cache(hash.get(), texels);
+    if (!from_cache) {
+        texels.assign((size_t)width * height, glm::vec3(0.0f));
+
+        // section of every triangle
+        std::vector<const StaticLevelMesh::Section*> triangle_section(triangles, nullptr);
+        for (const auto& section : level.get_sections()) {
+            for (GLsizei i = section.first_index; i < section.first_index + section.index_count; i += 3) {
+                triangle_section[i / 3] = &section;
+            }
+        }
+
+        // triangles write disjoint cells, workers only share the counter
+        std::atomic<int> next{ 0 };
+        std::atomic<long long> total_rays{ 0 };
+        auto worker = [&]() {
+            long long worker_rays = 0;
+            for (int t = next++; t < triangles; t = next++) {
+                if (triangle_section[t] != nullptr) {
+                    bake_triangle(&vertices[3 * t], *triangle_section[t], t, texels, worker_rays);
+                }
+            }
+            total_rays += worker_rays;
+        };
+        unsigned thread_count = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < thread_count; ++i) {
+            threads.emplace_back(worker);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        rays = total_rays;
+
+        save_cache(hash.get(), texels);
+    }
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, 1, GL_RGB16F, width, height);
+    glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, texels.data());
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    bake_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Lightmap " << (from_cache ? "loaded from cache" : "baked") << ": " << triangles
+              << " triangles, " << width << "x" << height << " atlas, " << rays << " rays, " << bake_ms
+              << " ms." << std::endl;
+}
+
+void LightmapBaker::bake_triangle(const Vertex* vertices, const StaticLevelMesh::Section& section, int cell,
+                                  std::vector<glm::vec3>& texels, long long& rays) const {
+    int cells_per_row = width / CELL;
+    glm::ivec2 corner((cell % cells_per_row) * CELL, (cell / cells_per_row) * CELL);
+
+    glm::vec3 a = vertices[0].Position;
+    glm::vec3 ab = vertices[1].Position - a;
+    glm::vec3 ac = vertices[2].Position - a;
+    glm::vec3 normal = glm::normalize(vertices[0].Normal);
+
+    for (int y = 0; y < CELL; ++y) {
+        for (int x = 0; x < CELL; ++x) {
+            // texels past the diagonal continue the plane, so bilinear filtering has no dark seam
+            float s = (float)x / (CELL - 1);
+            float t = (float)y / (CELL - 1);
+            // pushed off the surface like WorldPos in lighting.vert
+            glm::vec3 position = a + s * ab + t * ac + normal * 0.01f;
+
+            glm::vec3 ambient(0.0f), diffuse(0.0f);
+            for (const auto& light : lights) {
+                float distance = glm::distance(light.position, position);
+                if (distance >= light.range) {
+                    continue;
+                }
+                rays++;
+                if (!unoccluded(position, light.position)) {
+                    continue;
+                }
+                // same falloff as lighting.frag
+                float attenuation = 1.0f / (1.0f + 0.09f * distance + 0.032f * distance * distance);
+                float fade = glm::clamp(1.0f - std::pow(distance / light.range, 4.0f), 0.0f, 1.0f);
+                attenuation *= fade * fade;
+
+                glm::vec3 to_light = (light.position - position) / glm::max(distance, 1e-4f);
+                ambient += light.ambient * attenuation;
+                diffuse += glm::max(glm::dot(normal, to_light), 0.0f) * light.diffuse * attenuation;
+            }
+            texels[(size_t)(corner.y + y) * width + corner.x + x] =
+                section.ambient_material * ambient + section.diffuse_material * diffuse;
+        }
+    }
+}
+
+bool LightmapBaker::unoccluded(const glm::vec3& from, const glm::vec3& to) const {
+    glm::vec2 start = glm::vec2(from.x, from.z) - origin;
+    glm::vec2 direction = glm::vec2(to.x, to.z) - glm::vec2(from.x, from.z);
+    glm::ivec2 cell = glm::ivec2(glm::floor(start));
+    glm::ivec2 end = glm::ivec2(glm::floor(start + direction));
+    glm::ivec2 step = glm::ivec2(direction.x > 0.0f ? 1 : -1, direction.y > 0.0f ? 1 : -1);
+
+    // parametric distance (0..1 along the segment) to the next cell boundary (Amanatides & Woo)
+    glm::vec2 t_delta, t_max;
+    for (int axis = 0; axis < 2; ++axis) {
+        if (direction[axis] == 0.0f) {
+            t_delta[axis] = INFINITY;
+            t_max[axis] = INFINITY;
+        } else {
+            t_delta[axis] = std::abs(1.0f / direction[axis]);
+            float boundary = step[axis] > 0 ? cell[axis] + 1.0f : (float)cell[axis];
+            t_max[axis] = (boundary - start[axis]) / direction[axis];
+        }
+    }
+
+    float t_enter = 0.0f;
+    for (int steps = 0; steps <= cols + rows + 2; ++steps) {
+        float t_exit = glm::min(glm::min(t_max.x, t_max.y), 1.0f);
+        bool inside = cell.x >= 0 && cell.y >= 0 && cell.x < cols && cell.y < rows;
+        if (inside && walls[cell.y * cols + cell.x]) {
+            // the segment is a line, its lowest point in the tile is at the entry or the exit
+            float low = glm::min(glm::mix(from.y, to.y, t_enter), glm::mix(from.y, to.y, t_exit));
+            if (low < LightVisibility::WALL_TOP) {
+                return false;
+            }
+        }
+        if (cell == end || t_exit >= 1.0f) {
+            return true;
+        }
+        t_enter = t_exit;
+        if (t_max.x < t_max.y) {
+            cell.x += step.x;
+            t_max.x += t_delta.x;
+        } else {
+            cell.y += step.y;
+            t_max.y += t_delta.y;
+        }
+    }
+    return true;
+}
+
+std::filesystem::path LightmapBaker::cache_path(uint64_t key) const {
+    return CACHE_DIR / ("lightmap_" + Hash::to_hex(key) + ".bin");
+}
+
+bool LightmapBaker::load_cache(uint64_t key, std::vector<glm::vec3>& texels) const {
+    std::ifstream file(cache_path(key), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.key != key ||
+        header.width != width || header.height != height) {
+        return false;
+    }
+    texels.resize((size_t)width * height);
+    file.read(reinterpret_cast<char*>(texels.data()), texels.size() * sizeof(glm::vec3));
+    return (bool)file;
+}
+
+void LightmapBaker::save_cache(uint64_t key, const std::vector<glm::vec3>& texels) const {
+    std::error_code error;
+    std::filesystem::create_directories(CACHE_DIR, error);
+    std::ofstream file(cache_path(key), std::ios::binary);
+    if (error || !file) {
+        std::cerr << "Lightmap cache not writable: " << cache_path(key).string() << std::endl;
+        return;
+    }
+    CacheHeader header{ CACHE_MAGIC, CACHE_VERSION, key, width, height };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(glm::vec3));
+}
+
+void LightmapBaker::clear() {
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    walls.clear();
+    lights.clear();
+    triangles = width = height = 0;
+    rays = 0;
+    bake_ms = 0.0;
+    from_cache = false;
+}
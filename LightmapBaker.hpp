@@ -0,0 +1,90 @@
+#ifndef LIGHTMAPBAKER_HPP
+#define LIGHTMAPBAKER_HPP
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Light.hpp"
+#include "Map.hpp"
+#include "Model.hpp"
+#include "StaticLevelMesh.hpp"
+
+/* Diffuse and ambient lighting of the static walls baked into a lightmap atlas.
+ * Every triangle of StaticLevelMesh gets its own CELL x CELL block of texels.
+ * Texels are lit with the same attenuation as lighting.frag, and a ray is traced
+ * through the wall grid to every light (walls are LightVisibility::WALL_TOP high,
+ * doors do not block). Triangles are split between the hardware threads.
+ * The atlas is cached on disk under a hash of the level file, lights and geometry,
+ * so a level is baked only once. Specular light depends on the view and is not baked.
+ */
+class LightmapBaker {
+public:
+    static constexpr int CELL = 8; // texels per side of one triangle
+    inline static const std::filesystem::path CACHE_DIR = "cache/lightmaps";
+
+    // statistics of the last build()
+    int triangles = 0;
+    int width = 0;
+    int height = 0;
+    long long rays = 0;
+    double bake_ms = 0.0;
+    bool from_cache = false;
+
+    LightmapBaker() = default;
+    LightmapBaker(const LightmapBaker&) = delete;
+    LightmapBaker& operator=(const LightmapBaker&) = delete;
+    ~LightmapBaker() { clear(); }
+
+    /* Bake (or load from cache) the lightmap of a level and give its coordinates to the mesh
+     * @param level_file: path to the level text file (part of the cache key)
+     * @param map: level map
+     * @param prototypes: token -> prototype model
+     * @param level: baked static walls, receives the lightmap coordinates
+     * @param lights: lights of the level
+     * @param offset: map to world offset (same as used for placing models)
+     */
+    void build(const std::string& level_file, Map& map, std::unordered_map<std::string, Model>& prototypes,
+               StaticLevelMesh& level, const std::vector<Light>& lights, const glm::vec3& offset);
+
+    bool ready() const { return texture != 0; }
+    GLuint get_texture() const { return texture; }
+
+    void clear();
+
+private:
+    struct LightInfo {
+        glm::vec3 position;
+        glm::vec3 ambient;
+        glm::vec3 diffuse;
+        float range;
+    };
+
+    GLuint texture{ 0 };
+    int cols = 0;
+    int rows = 0;
+    glm::vec2 origin{ 0.0f };
+    std::vector<char> walls; // static blockers per tile
+    std::vector<LightInfo> lights;
+
+    /* Can light travel from one point to another without hitting a wall?
+     * Walks the tiles under the segment and compares its height with the wall top.
+     */
+    bool unoccluded(const glm::vec3& from, const glm::vec3& to) const;
+
+    /* Light all texels of one triangle
+     * @param rays: incremented by the number of traced rays
+     */
+    void bake_triangle(const Vertex* vertices, const StaticLevelMesh::Section& section, int cell,
+                       std::vector<glm::vec3>& texels, long long& rays) const;
+
+    std::filesystem::path cache_path(uint64_t key) const;
+    bool load_cache(uint64_t key, std::vector<glm::vec3>& texels) const;
+    void save_cache(uint64_t key, const std::vector<glm::vec3>& texels) const;
+};
+
+#endif // LIGHTMAPBAKER_HPP
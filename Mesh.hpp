@@ -7,8 +7,10 @@
 #include <glm/glm.hpp> 
 #include <glm/ext.hpp>
 #include <iostream>
+#include <memory>
 
 #include "assets.hpp"
+#include "MeshBuffers.hpp"
 #include "Vertex.hpp"
 #include "ShaderProgram.hpp"
 
@@ -32,96 +34,23 @@ public:
     Mesh() = delete;
 
     Mesh(GLenum primitive_type, ShaderProgram & shader, std::vector<Vertex> const & vertices, std::vector<GLuint> const & indices, glm::vec3 const & origin, glm::vec3 const & orientation, GLuint const texture_id = 0):
+        Mesh(primitive_type, shader, std::make_shared<MeshBuffers>(vertices, indices), origin, orientation, texture_id)
+    {
+    }
+
+    // mesh sharing already uploaded GPU buffers (see MeshBuffers::load)
+    Mesh(GLenum primitive_type, ShaderProgram & shader, std::shared_ptr<MeshBuffers> buffers, glm::vec3 const & origin, glm::vec3 const & orientation, GLuint const texture_id = 0):
         primitive_type(primitive_type),
         shader(shader),
-        vertices(vertices),
-        indices(indices),
+        buffers(std::move(buffers)),
         origin(origin),
         orientation(orientation),
         texture_id(texture_id)
     {
-        /*
-        GLuint position_attribute_location = glGetAttribLocation(shader.getID(), "atrribute_position");
-        glEnableVertexArrayAttrib(VAO, position_attribute_location);
-        glVertexArrayAttribFormat(VAO, position_attribute_location, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
-        // (GLuint vaobj, GLuint attribindex, GLuint bindingindex)
-        glVertexArrayAttribBinding(VAO, position_attribute_location, 0);
-
-        // Create and fill data
-        glCreateBuffers(1, &VBO);
-        glNamedBufferData(VBO, vertices.size()*sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-        // Connect together
-        glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(Vertex));
-        */
-        
-        ///*
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-
-        glBindVertexArray(0);
-        //*/
     }
 
-    // Copy constructor
-    Mesh(const Mesh& other) 
-        : origin(other.origin),
-          orientation(other.orientation),
-          texture_id(other.texture_id),
-          primitive_type(other.primitive_type),
-          shader(other.shader),
-          ambient_material(other.ambient_material),
-          diffuse_material(other.diffuse_material),
-          specular_material(other.specular_material),
-          reflectivity(other.reflectivity),
-          vertices(other.vertices),
-          indices(other.indices),
-          VBO(0),
-          VAO(0),
-          EBO(0)
-    {
-        // Generate and bind VAO, VBO, and EBO
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-
-        glBindVertexArray(0);
-    }
+    // Copy constructor - GPU buffers are shared, not uploaded again
+    Mesh(const Mesh& other) = default;
 
     // Copy assignment operator
     Mesh& operator=(const Mesh& other) {
@@ -135,67 +64,43 @@ public:
             diffuse_material = other.diffuse_material;
             specular_material = other.specular_material;
             reflectivity = other.reflectivity;
-            vertices = other.vertices;
-            indices = other.indices;
-
-            // Generate and bind VAO, VBO, and EBO
-            glGenVertexArrays(1, &VAO);
-            glGenBuffers(1, &VBO);
-            glGenBuffers(1, &EBO);
-
-            glBindVertexArray(VAO);
-
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-
-            glEnableVertexAttribArray(1);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-
-            glEnableVertexAttribArray(2);
-            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-
-            glBindVertexArray(0);
+            buffers = other.buffers;
         }
         return *this;
     }
 
     void draw(glm::mat4 const & model_matrix) const {
-        if (VAO == 0) {
+        if (!buffers || buffers->VAO == 0) {
             std::cerr << "VAO not initialized!\n";
             return;
         }
         
         shader.activate();
+        // handles resolved at link time, no string lookups per draw
+        const ShaderProgram::CommonUniforms& uniforms = shader.common();
         
         // Set uniform matrices (you already fixed this in Step 1)
-        shader.setUniform("m_m", model_matrix);
+        uniforms.m_m.set(model_matrix);
         
         // --- ADD THIS NEW SECTION ---
         // Set material properties from the mesh's member variables
         // Note: The shader expects vec3, but your class stores vec4. We cast it by creating a vec3.
-        if (shader.hasUniform("specular_shinines")) { // "specular_shinines" is unique to your lighting shader
-            shader.setUniform("ambient_material", ambient_material);
-            shader.setUniform("diffuse_material", diffuse_material);
-            shader.setUniform("specular_material", specular_material);
-            shader.setUniform("specular_shinines", reflectivity);
+        if (uniforms.specular_shinines) { // "specular_shinines" is unique to your lighting shader
+            uniforms.ambient_material.set(ambient_material);
+            uniforms.diffuse_material.set(diffuse_material);
+            uniforms.specular_material.set(specular_material);
+            uniforms.specular_shinines.set(reflectivity);
         }
     
         // Bind the texture and set the sampler uniform
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, texture_id);
-        shader.setUniform("tex0", 0); // Tell the shader to use texture unit 0 for the 'tex0' sampler
+        uniforms.tex0.set(0); // Tell the shader to use texture unit 0 for the 'tex0' sampler
         // --- END OF NEW SECTION ---
         
-        glBindVertexArray(VAO);
+        glBindVertexArray(buffers->VAO);
     
-        glDrawElements(primitive_type, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        glDrawElements(primitive_type, (GLsizei)buffers->indices.size(), GL_UNSIGNED_INT, 0);
     }
 
     void draw(glm::vec3 const & offset = glm::vec3(0.0), glm::vec3 const & rotation = glm::vec3(0.0f)) {
@@ -212,34 +117,17 @@ public:
     void clear(void) {
         texture_id = 0;
         primitive_type = GL_POINT;
-        vertices.clear();
-        indices.clear();
         origin = glm::vec3(0.0f);
         orientation = glm::vec3(0.0f);
-
-        if (VBO != 0) {
-            glDeleteBuffers(1, &VBO);
-            VBO = 0;
-        }
-        if (EBO != 0) {
-            glDeleteBuffers(1, &EBO);
-            EBO = 0;
-        }
-        if (VAO != 0) {
-            glDeleteVertexArrays(1, &VAO);
-            VAO = 0;
-        }
+        // buffers are deleted once the last mesh sharing them lets go
+        buffers.reset();
     }
 
+    std::shared_ptr<MeshBuffers> const & get_buffers() const { return buffers; }
+
 private:
-    // OpenGL buffer IDs
-    // ID = 0 is reserved (i.e. uninitalized)
-    
-    GLuint VBO{ 0 };
-    GLuint VAO{ 0 };
-    GLuint EBO{ 0 };
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
+    // GPU data, shared between copies of the mesh
+    std::shared_ptr<MeshBuffers> buffers;
 };
 
 #endif // MESH_HPP
@@ -0,0 +1,157 @@
+#ifndef MESHBUFFERS_HPP
+#define MESHBUFFERS_HPP
+
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "OBJloader.hpp"
+#include "Vertex.hpp"
+
+/* GPU side of a mesh - VAO, VBO and EBO together with the CPU copy of the data.
+ * One instance is shared (std::shared_ptr) by all Mesh copies made from the same
+ * source, so copying a Model does not upload anything to the GPU.
+ * Buffers are deleted in the destructor, i.e. when the last user goes away.
+ */
+class MeshBuffers {
+public:
+    // OpenGL buffer IDs
+    // ID = 0 is reserved (i.e. uninitalized)
+    GLuint VAO{ 0 };
+    GLuint VBO{ 0 };
+    GLuint EBO{ 0 };
+    // position-only stream (attribute 0) for depth-only passes, shares EBO
+    GLuint depth_VAO{ 0 };
+    GLuint position_VBO{ 0 };
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    AABB bounds; // local space bounding box of the vertices
+
+    MeshBuffers(std::vector<Vertex> const & vertices, std::vector<GLuint> const & indices):
+        vertices(vertices),
+        indices(indices)
+    {
+        for (const auto& vertex : vertices) {
+            bounds.extend(vertex.Position);
+        }
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
+
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+
+        // positions split out of Vertex, so the depth pre-pass fetches 12 instead of 32 bytes per vertex
+        std::vector<glm::vec3> positions;
+        positions.reserve(vertices.size());
+        for (const auto& vertex : vertices) {
+            positions.push_back(vertex.Position);
+        }
+        glGenVertexArrays(1, &depth_VAO);
+        glGenBuffers(1, &position_VBO);
+
+        glBindVertexArray(depth_VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, position_VBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+        glBindVertexArray(0);
+    }
+
+    // GPU buffers are owned - no copies
+    MeshBuffers(const MeshBuffers&) = delete;
+    MeshBuffers& operator=(const MeshBuffers&) = delete;
+
+    ~MeshBuffers() {
+        if (VBO != 0) {
+            glDeleteBuffers(1, &VBO);
+        }
+        if (EBO != 0) {
+            glDeleteBuffers(1, &EBO);
+        }
+        if (VAO != 0) {
+            glDeleteVertexArrays(1, &VAO);
+        }
+        if (position_VBO != 0) {
+            glDeleteBuffers(1, &position_VBO);
+        }
+        if (depth_VAO != 0) {
+            glDeleteVertexArrays(1, &depth_VAO);
+        }
+    }
+
+    /* Load mesh from OBJ file, or return the already uploaded one.
+     * The cache holds only weak references, so the buffers are released
+     * as soon as no Mesh uses them.
+     * @param filename: path to the OBJ file
+     * @return: shared GPU mesh
+     */
+    static std::shared_ptr<MeshBuffers> load(const std::filesystem::path& filename) {
+        std::string key = filename.lexically_normal().string();
+        auto it = cache.find(key);
+        if (it != cache.end()) {
+            if (auto buffers = it->second.lock()) {
+                return buffers;
+            }
+        }
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+
+        if (!loadOBJ(filename.string().c_str(), positions, uvs, normals)) {
+            throw std::runtime_error("Failed to load model from " + filename.string());
+        }
+
+        std::vector<Vertex> vertex_data;
+        vertex_data.reserve(positions.size());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            Vertex vertex;
+            vertex.Position = positions[i];
+            vertex.Normal = normals[i];
+            vertex.TexCoords = uvs[i];
+            vertex_data.push_back(vertex);
+        }
+
+        std::vector<GLuint> index_data(vertex_data.size());
+        std::iota(index_data.begin(), index_data.end(), 0);
+
+        auto buffers = std::make_shared<MeshBuffers>(vertex_data, index_data);
+        cache[key] = buffers;
+        return buffers;
+    }
+
+private:
+    // OBJ path -> uploaded mesh
+    inline static std::unordered_map<std::string, std::weak_ptr<MeshBuffers>> cache;
+};
+
+#endif // MESHBUFFERS_HPP
@@ -37,6 +37,23 @@ Model Model::parse_json_to_model(const nlohmann::json& model_data, Model& model,
     
     std::string name = model_data["model_name"];
     std::string token = model_data["token"];
+    model.token = token;
+
+    std::string material;
+    load_value_from_json(model_data, "material", material);
+    if (material == "cutout") {
+        // alpha tested variant of the base model, e.g. "sprite_cutout" in models.json
+        auto variant = model_cache.find(name + "_cutout");
+        if (variant == model_cache.end()) {
+            throw std::runtime_error("Model " + name + " has no cutout variant (" + name + "_cutout).");
+        }
+        // copy constructed, Mesh::shader is a reference
+        model.meshes.clear();
+        model.meshes.insert(model.meshes.end(), variant->second.meshes.begin(), variant->second.meshes.end());
+        model.cutout = true;
+    } else if (!material.empty()) {
+        throw std::runtime_error("Unknown material: " + material);
+    }
 
     if (model_data.find("texture_path") != model_data.end()) {
         model.texture_id = textureInit(model_data["texture_path"]);
@@ -47,6 +64,8 @@ Model Model::parse_json_to_model(const nlohmann::json& model_data, Model& model,
     }
 
     load_value_from_json(model_data, "transparent", model.transparent);
+    // cutout models are opaque with holes, never blended
+    model.transparent = model.transparent && !model.cutout;
     load_value_from_json(model_data, "solid", model.isSolid);
     load_value_from_json(model_data, "collectible", model.collectible);
     load_value_from_json(model_data, "collect_type", model.collect_type);
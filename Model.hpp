@@ -20,14 +20,20 @@ class Model {
 public:
     std::vector<Mesh> meshes;
     std::string name;
+    std::string token; // map token from map_2_models.json (empty for non-map models)
     glm::vec3 origin{};
     glm::vec3 orientation{};
     glm::vec3 scale{};
     glm::mat4 local_model_matrix{}; //for complex transformations 
 
     GLuint texture_id{0}; // texture id=0  means no texture
+    // shared GL_TEXTURE_2D_ARRAY (see "texture_array" in map_2_models.json), 0 = not packed
+    GLuint texture_array_id{0};
+    int texture_layer{0}; // layer of this model's texture in texture_array_id
     bool isSprite = false;
     bool transparent = false;
+    // alpha tested ("material": "cutout" in map_2_models.json), drawn in the opaque pass
+    bool cutout = false;
     // for collectible objects
     bool collectible = false; 
     std::string collect_type = "";
@@ -41,6 +47,8 @@ public:
     bool isSolid = false;
     // for end level objects
     bool end_level = false; 
+    // geometry merged into StaticLevelMesh, the model is kept for collisions only
+    bool baked = false;
 
     // for light sources
     bool light_source = false;
@@ -82,6 +90,8 @@ public:
         std::string path = model_data["obj_path"];
         std::filesystem::path vertex_shader_path = model_data["vertex_shader_path"];
         std::filesystem::path fragment_shader_path = model_data["fragment_shader_path"];
+        // volitelná permutace shaderu, např. ["ALPHA_TEST 1"]
+        std::vector<std::string> defines = model_data.value("defines", std::vector<std::string>{});
 
         // Kontrola existence shaderů
         if (!std::filesystem::exists(vertex_shader_path) ||
@@ -96,14 +106,13 @@ public:
         }
 
         // Načtení nebo vytvoření shaderu
-        std::string shader_key = vertex_shader_path.string() + fragment_shader_path.string();
+        std::string shader_key = ShaderProgram::cache_key(vertex_shader_path, fragment_shader_path, defines);
         if (shader_cache.find(shader_key) == shader_cache.end()) {
-            shader_cache[shader_key] = ShaderProgram(vertex_shader_path, fragment_shader_path);
-            std::cout << "Shader program ID: " << shader_cache[shader_key].getID()
-                      << " compiled and cached." << std::endl;
+            // linked on first use, the driver compiles in the meantime
+            shader_cache[shader_key] = ShaderProgram(vertex_shader_path, fragment_shader_path, defines);
+            std::cout << "Shader program " << shader_key << " queued and cached." << std::endl;
         } else {
-            std::cout << "Shader program ID: " << shader_cache[shader_key].getID()
-                      << " loaded from cache." << std::endl;
+            std::cout << "Shader program " << shader_key << " loaded from cache." << std::endl;
         }
 
         // Inicializace modelu
@@ -119,27 +128,10 @@ public:
         // properties
         //    notice: you can load multiple meshes and place them to proper positions,
         //            multiple textures (with reusing) etc. to construct single complicated Model
-        std::vector<glm::vec3> vertices;
-        std::vector<glm::vec2> uvs;
-        std::vector<glm::vec3> normals;
+        // GPU buffers are uploaded once per OBJ file and shared by all models using it
+        std::shared_ptr<MeshBuffers> buffers = MeshBuffers::load(filename);
 
-        if (!loadOBJ(filename.c_str(), vertices, uvs, normals)) {
-            throw std::runtime_error("Failed to load model from " + filename.string());
-        }
-
-        std::vector<Vertex> vertexData;
-        for (size_t i = 0; i < vertices.size(); ++i) {
-            Vertex vertex;
-            vertex.Position = vertices[i];
-            vertex.Normal = normals[i];
-            vertex.TexCoords = uvs[i];
-            vertexData.push_back(vertex);
-        }
-
-        std::vector<GLuint> indices(vertexData.size());
-        std::iota(indices.begin(), indices.end(), 0);
-
-        meshes.emplace_back(GL_TRIANGLES, shader, vertexData, indices, origin, orientation);
+        meshes.emplace_back(GL_TRIANGLES, shader, buffers, origin, orientation);
         init_position();
     }
 
@@ -152,13 +144,17 @@ public:
     Model(const Model& other): 
         meshes(other.meshes),
         name(other.name),
+        token(other.token),
         origin(other.origin),
         orientation(other.orientation),
         scale(other.scale),
         texture_id(other.texture_id),
+        texture_array_id(other.texture_array_id),
+        texture_layer(other.texture_layer),
         local_model_matrix(other.local_model_matrix),
         isSprite(other.isSprite),
         transparent(other.transparent),
+        cutout(other.cutout),
         collectible(other.collectible),
         collect_type(other.collect_type),
         value(other.value),
@@ -169,6 +165,7 @@ public:
         isDoor(other.isDoor),
         isSolid(other.isSolid),
         end_level(other.end_level),
+        baked(other.baked),
         ambientLight(other.ambientLight),
         diffuseLight(other.diffuseLight),
         specularLight(other.specularLight),
@@ -200,12 +197,17 @@ public:
     }
     */
 
-    virtual void draw(glm::vec3 const & offset = glm::vec3(0.0),
+    /* Compute model matrix from the model position and the per-draw change
+     * (local_model_matrix is not included, it is applied in draw(glm::mat4))
+     * @param offset: additional translation
+     * @param rotation: additional rotation
+     * @param scale_change: additional scale
+     * @return: model matrix
+     */
+    glm::mat4 compute_model_matrix(glm::vec3 const & offset = glm::vec3(0.0),
                   glm::vec3 const & rotation = glm::vec3(0.0f),
-                  glm::vec3 const & scale_change = glm::vec3(1.0f) ) 
+                  glm::vec3 const & scale_change = glm::vec3(1.0f) ) const
     {
-    // This function's only job is to calculate the final model matrix.
-    // Your existing calculations are here.
     glm::mat4 t = glm::translate(glm::mat4(1.0f), origin);
     glm::mat4 rx = glm::rotate(glm::mat4(1.0f), orientation.x, glm::vec3(1.0f, 0.0f, 0.0f));
     glm::mat4 ry = glm::rotate(glm::mat4(1.0f), orientation.y, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -218,11 +220,50 @@ public:
     glm::mat4 m_rz = glm::rotate(glm::mat4(1.0f), rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
     glm::mat4 m_s = glm::scale(glm::mat4(1.0f), scale_change);
 
-    glm::mat4 model_matrix = s * rz * ry * rx * t * m_s * m_rz * m_ry * m_rx * m_off;
+    return s * rz * ry * rx * t * m_s * m_rz * m_ry * m_rx * m_off;
+    }
+
+    /* World space bounding box from the mesh vertices, scale and position.
+     * Rotation around Y is ignored (the box is widened to the XZ radius),
+     * so the box also holds for sprites turned to the camera.
+     * @return: box, invalid if the model has no mesh
+     */
+    AABB bounds() const {
+        AABB local;
+        for (auto const & mesh : meshes) {
+            if (mesh.get_buffers()) {
+                local.extend(mesh.get_buffers()->bounds);
+            }
+        }
+        if (!local.valid()) {
+            return local;
+        }
+        float radius = glm::max(glm::max(glm::length(glm::vec2(local.min.x, local.min.z)),
+                                         glm::length(glm::vec2(local.max.x, local.max.z))),
+                                glm::max(glm::length(glm::vec2(local.min.x, local.max.z)),
+                                         glm::length(glm::vec2(local.max.x, local.min.z))));
+        AABB round;
+        round.min = glm::vec3(-radius, local.min.y, -radius);
+        round.max = glm::vec3(radius, local.max.y, radius);
+        return round.transformed(local_model_matrix * compute_model_matrix());
+    }
+
+    // models spanning more map tiles than this (floor) are not bound to a single tile
+    static constexpr float LARGE_SIZE = 2.0f;
 
-    // We removed the old texture code from here because it was not in the right place.
-    // Now, we just call the other draw function with the final matrix.
-    draw(model_matrix);
+    /* @param box: bounds() of the model
+     * @return: true if the box spans more than LARGE_SIZE tiles in X or Z
+     */
+    static bool is_large(const AABB & box) {
+        glm::vec3 size = box.size();
+        return size.x > LARGE_SIZE || size.z > LARGE_SIZE;
+    }
+
+    virtual void draw(glm::vec3 const & offset = glm::vec3(0.0),
+                  glm::vec3 const & rotation = glm::vec3(0.0f),
+                  glm::vec3 const & scale_change = glm::vec3(1.0f) ) 
+    {
+    draw(compute_model_matrix(offset, rotation, scale_change));
     }
 
     // This function now does the actual drawing.
@@ -242,6 +283,7 @@ public:
     void interact() {}
 };
 
+cv::Mat textureLoad(const std::filesystem::path& file_name);
 GLuint textureInit(const std::filesystem::path& file_name);
 Model parse_json_to_model(const nlohmann::json& model_data, Model& model,
                          std::unordered_map<std::string, Model> model_cache);
@@ -0,0 +1,127 @@
+#include "OcclusionQueries.hpp"
+
+#include <glm/ext.hpp>
+
+void OcclusionQueries::init(ShaderProgram& shader) {
+    clear();
+    this->shader = &shader;
+
+    // unit cube [0, 1]^3, scaled to each box
+    const glm::vec3 vertices[8] = {
+        { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 },
+        { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 },
+    };
+    const GLuint indices[36] = {
+        0, 2, 1, 0, 3, 2, // -z
+        4, 5, 6, 4, 6, 7, // +z
+        0, 4, 7, 0, 7, 3, // -x
+        1, 2, 6, 1, 6, 5, // +x
+        0, 1, 5, 0, 5, 4, // -y
+        3, 7, 6, 3, 6, 2, // +y
+    };
+
+    glCreateVertexArrays(1, &VAO);
+    glCreateBuffers(1, &VBO);
+    glCreateBuffers(1, &EBO);
+    glNamedBufferStorage(VBO, sizeof(vertices), vertices, 0);
+    glNamedBufferStorage(EBO, sizeof(indices), indices, 0);
+
+    glVertexArrayVertexBuffer(VAO, 0, VBO, 0, sizeof(glm::vec3));
+    glVertexArrayElementBuffer(VAO, EBO);
+    glEnableVertexArrayAttrib(VAO, 0);
+    glVertexArrayAttribFormat(VAO, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(VAO, 0, 0);
+}
+
+void OcclusionQueries::begin(unsigned version) {
+    tested = 0;
+    issued = 0;
+    hidden = 0;
+    if (version != entries_version) {
+        // models were removed, their queries may belong to freed objects
+        reset();
+        entries_version = version;
+    }
+}
+
+void OcclusionQueries::test(const std::vector<Model*>& models, const glm::vec3& camera_position) {
+    if (VAO == 0 || models.empty()) {
+        return;
+    }
+
+    // boxes only touch the depth test
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+    shader->activate();
+    Uniform<glm::mat4> m_m = shader->common().m_m;
+    glBindVertexArray(VAO);
+
+    for (const Model* model : models) {
+        if (!accepts(*model)) {
+            continue;
+        }
+        Entry& entry = entries[model];
+        AABB box = model->bounds();
+        bool inside = glm::all(glm::greaterThanEqual(camera_position, box.min - NEAR_MARGIN)) &&
+                      glm::all(glm::lessThanEqual(camera_position, box.max + NEAR_MARGIN));
+        if (!box.valid() || inside) {
+            // the box would be clipped by the near plane, always draw
+            entry.use = false;
+            continue;
+        }
+        tested++;
+
+        if (entry.query == 0) {
+            glCreateQueries(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, 1, &entry.query);
+        }
+        if (entry.pending) {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(entry.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                // GPU is still behind, keep drawing against the old result
+                hidden += entry.visible ? 0 : 1;
+                continue;
+            }
+            GLuint result = GL_TRUE;
+            glGetQueryObjectuiv(entry.query, GL_QUERY_RESULT, &result);
+            entry.visible = result != GL_FALSE;
+            entry.pending = false;
+        }
+        hidden += entry.visible ? 0 : 1;
+
+        m_m.set(glm::scale(glm::translate(glm::mat4(1.0f), box.min), box.size()));
+        glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, entry.query);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+        entry.pending = true;
+        entry.use = true;
+        issued++;
+    }
+
+    glBindVertexArray(0);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_CULL_FACE);
+}
+
+void OcclusionQueries::reset() {
+    for (auto& [model, entry] : entries) {
+        if (entry.query != 0) {
+            glDeleteQueries(1, &entry.query);
+        }
+    }
+    entries.clear();
+}
+
+void OcclusionQueries::clear() {
+    reset();
+    if (VAO != 0) {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+    }
+    shader = nullptr;
+    tested = issued = hidden = 0;
+}
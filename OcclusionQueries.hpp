@@ -0,0 +1,88 @@
+#ifndef OCCLUSIONQUERIES_HPP
+#define OCCLUSIONQUERIES_HPP
+
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "Model.hpp"
+#include "ShaderProgram.hpp"
+
+/* Hardware occlusion queries for sprites, enemies and collectibles.
+ * After the opaque walls are drawn, the bounding box of each tested model is rasterized
+ * (no color or depth writes) inside a GL_ANY_SAMPLES_PASSED_CONSERVATIVE query, the real
+ * model is then drawn with glBeginConditionalRender. A query is re-issued only once its
+ * previous result is available, so the CPU never waits and an old result is reused
+ * until the GPU catches up.
+ */
+class OcclusionQueries {
+public:
+    // statistics of the last frame
+    int tested = 0;  // models with a query
+    int issued = 0;  // box draws this frame
+    int hidden = 0;  // models with the last known result "no samples"
+
+    OcclusionQueries() = default;
+    OcclusionQueries(const OcclusionQueries&) = delete;
+    OcclusionQueries& operator=(const OcclusionQueries&) = delete;
+    ~OcclusionQueries() { clear(); }
+
+    // models worth testing - small entities standing in the rooms
+    static bool accepts(const Model& model) {
+        return model.isSprite || model.collectible || model.isEnemy;
+    }
+
+    /* Create box geometry
+     * @param shader: position only shader (occlusion_box.vert/frag)
+     */
+    void init(ShaderProgram& shader);
+
+    /* Start a frame, reset statistics
+     * @param version: App::models_version, queries of removed models are dropped when it changes
+     */
+    void begin(unsigned version);
+
+    /* Issue box queries for models, must be called after opaque geometry is in the depth buffer
+     * @param models: candidates (models not accepted are ignored)
+     * @param camera_position: world position of the camera, boxes around it are not tested
+     */
+    void test(const std::vector<Model*>& models, const glm::vec3& camera_position);
+
+    /* Query to draw the model conditionally with
+     * @param model: drawn model
+     * @return: query id, 0 = draw unconditionally
+     */
+    GLuint query(const Model& model) const {
+        auto it = entries.find(&model);
+        return it != entries.end() && it->second.use ? it->second.query : 0;
+    }
+
+    // drop all queries (level change)
+    void reset();
+
+    void clear();
+
+private:
+    struct Entry {
+        GLuint query = 0;
+        bool pending = false; // result not read yet
+        bool use = false;     // query holds a result usable for this frame
+        bool visible = true;  // last result read back
+    };
+
+    // camera closer than this to a box is treated as inside (near plane)
+    static constexpr float NEAR_MARGIN = 0.2f;
+
+    ShaderProgram* shader = nullptr;
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    GLuint EBO = 0;
+
+    std::unordered_map<const Model*, Entry> entries;
+    unsigned entries_version = 0;
+};
+
+#endif // OCCLUSIONQUERIES_HPP
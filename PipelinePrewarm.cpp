@@ -0,0 +1,71 @@
+#include "PipelinePrewarm.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+void PipelinePrewarm::create_target() {
+    glCreateRenderbuffers(1, &color_buffer);
+    glNamedRenderbufferStorage(color_buffer, GL_RGBA8, 1, 1);
+    // same depth format as the default framebuffer
+    glCreateRenderbuffers(1, &depth_buffer);
+    glNamedRenderbufferStorage(depth_buffer, GL_DEPTH24_STENCIL8, 1, 1);
+
+    glCreateFramebuffers(1, &FBO);
+    glNamedFramebufferRenderbuffer(FBO, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer);
+    glNamedFramebufferRenderbuffer(FBO, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_buffer);
+
+    if (glCheckNamedFramebufferStatus(FBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw std::runtime_error("Pre-warm framebuffer is not complete.");
+    }
+}
+
+void PipelinePrewarm::begin() {
+    entries.clear();
+    total_ms = 0.0;
+    if (FBO == 0) {
+        create_target();
+    }
+
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glViewport(0, 0, 1, 1);
+
+    // start measuring from an idle GPU
+    glFinish();
+}
+
+void PipelinePrewarm::measure(const std::string& name, const std::function<int()>& draw) {
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+    auto start = std::chrono::steady_clock::now();
+    Entry entry;
+    entry.name = name;
+    entry.draw_calls = draw();
+    // validation and uploads are deferred by the driver until the GPU needs them
+    glFinish();
+    entry.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    total_ms += entry.ms;
+    entries.push_back(entry);
+}
+
+void PipelinePrewarm::end() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    std::cout << "Pipeline pre-warm: " << entries.size() << " entries in " << total_ms << " ms" << std::endl;
+    for (const Entry& entry : entries) {
+        std::cout << "  '" << entry.name << "': " << entry.ms << " ms, " << entry.draw_calls << " draw calls"
+                  << std::endl;
+    }
+}
+
+void PipelinePrewarm::clear() {
+    if (FBO != 0) {
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteRenderbuffers(1, &color_buffer);
+        glDeleteRenderbuffers(1, &depth_buffer);
+        FBO = color_buffer = depth_buffer = 0;
+    }
+    entries.clear();
+    total_ms = 0.0;
+}
@@ -0,0 +1,64 @@
+#ifndef PIPELINEPREWARM_HPP
+#define PIPELINEPREWARM_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+/* Offscreen pass drawing every model prototype once at level load.
+ * Drivers validate a program/texture/VAO combination and upload its resources
+ * lazily on the first draw, which shows as a hitch the first time a model
+ * appears (a corpse, a picked up weapon). Here the first draw goes into
+ * a throwaway 1x1 framebuffer instead. The draws themselves are issued by the caller
+ * through the same renderers as in the game (see App::prewarm_pipeline), passes with
+ * their own targets (deferred, OIT) resolve into get_framebuffer() instead of the window.
+ * Usage: begin(), measure() per prototype, end().
+ */
+class PipelinePrewarm {
+public:
+    // cost of the first draw of one prototype
+    struct Entry {
+        std::string name;
+        double ms = 0.0;
+        int draw_calls = 0;
+    };
+
+    PipelinePrewarm() = default;
+    PipelinePrewarm(const PipelinePrewarm&) = delete;
+    PipelinePrewarm& operator=(const PipelinePrewarm&) = delete;
+    ~PipelinePrewarm() { clear(); }
+
+    /* Bind the 1x1 target and start a new report */
+    void begin();
+
+    /* Run one warm-up draw and measure it (waits for the GPU)
+     * @param name: map token or render path in the report
+     * @param draw: issues the draws, returns the number of draw calls
+     */
+    void measure(const std::string& name, const std::function<int()>& draw);
+
+    /* Restore the default framebuffer and viewport, print the report */
+    void end();
+
+    // 1x1 target, valid between begin() and end()
+    GLuint get_framebuffer() const { return FBO; }
+
+    const std::vector<Entry>& get_entries() const { return entries; }
+    double get_total_ms() const { return total_ms; }
+
+    void clear();
+
+private:
+    GLuint FBO = 0;
+    GLuint color_buffer = 0;
+    GLuint depth_buffer = 0;
+    GLint viewport[4] = { 0, 0, 0, 0 };
+    std::vector<Entry> entries;
+    double total_ms = 0.0;
+
+    void create_target();
+};
+
+#endif // PIPELINEPREWARM_HPP
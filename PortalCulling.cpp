@@ -0,0 +1,178 @@
+#include "PortalCulling.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+void PortalCulling::build(Map& map, std::unordered_map<std::string, Model>& prototypes,
+                          const std::vector<std::unique_ptr<Model>>& models, const glm::vec3& offset) {
+    clear();
+    cols = map.getCols();
+    rows = map.getRows();
+    // tile (i, j) is centered at (i, 0, j) + offset
+    origin = glm::vec2(offset.x, offset.z) - 0.5f;
+
+    enum TileKind : char { Open, Wall, DoorTile };
+    std::vector<char> kind(cols * rows, Open);
+    for (int j = 0; j < rows; j++) {
+        for (int i = 0; i < cols; i++) {
+            auto it = prototypes.find(std::string(1, map.fetchMapValue(i, j)));
+            if (it == prototypes.end()) {
+                continue;
+            }
+            const Model& prototype = it->second;
+            if (prototype.isDoor) {
+                kind[j * cols + i] = DoorTile;
+            } else if (!prototype.isSprite && !prototype.transparent) {
+                // solid cubes block the view
+                kind[j * cols + i] = Wall;
+            }
+        }
+    }
+
+    // flood-fill open tiles into rooms
+    std::vector<int> room(cols * rows, NO_ROOM);
+    const glm::ivec2 neighbours[4] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    for (int start = 0; start < cols * rows; ++start) {
+        if (kind[start] != Open || room[start] != NO_ROOM) {
+            continue;
+        }
+        room[start] = room_count;
+        stack.assign(1, start);
+        while (!stack.empty()) {
+            int index = stack.back();
+            stack.pop_back();
+            glm::ivec2 tile(index % cols, index / cols);
+            for (const auto& n : neighbours) {
+                glm::ivec2 next = tile + n;
+                int next_index = next.y * cols + next.x;
+                if (in_map(next) && kind[next_index] == Open && room[next_index] == NO_ROOM) {
+                    room[next_index] = room_count;
+                    stack.push_back(next_index);
+                }
+            }
+        }
+        room_count++;
+    }
+
+    // rooms touching each tile
+    tile_rooms.assign(cols * rows, { NO_ROOM, NO_ROOM, NO_ROOM, NO_ROOM });
+    for (int index = 0; index < cols * rows; ++index) {
+        auto& rooms = tile_rooms[index];
+        if (kind[index] == Open) {
+            rooms[0] = room[index];
+            continue;
+        }
+        glm::ivec2 tile(index % cols, index / cols);
+        int count = 0;
+        for (const auto& n : neighbours) {
+            glm::ivec2 next = tile + n;
+            if (!in_map(next)) {
+                continue;
+            }
+            int r = room[next.y * cols + next.x];
+            if (r != NO_ROOM && std::find(rooms.begin(), rooms.end(), r) == rooms.end()) {
+                rooms[count++] = r;
+            }
+        }
+    }
+
+    // portals - doors between rooms
+    room_portals.assign(room_count, {});
+    for (const auto& model : models) {
+        const Door* door = dynamic_cast<const Door*>(model.get());
+        if (door == nullptr) {
+            continue;
+        }
+        glm::ivec2 tile = tile_of(door->origin);
+        if (!in_map(tile)) {
+            continue;
+        }
+        const auto& rooms = tile_rooms[tile.y * cols + tile.x];
+        if (rooms[0] == NO_ROOM || rooms[1] == NO_ROOM) {
+            // dead end door, nothing behind it
+            continue;
+        }
+        Portal portal;
+        portal.door = door;
+        portal.tile = tile;
+        portal.rooms = { rooms[0], rooms[1] };
+        portal.box.min = glm::vec3(origin.x + tile.x, door->origin.y - 0.5f, origin.y + tile.y);
+        portal.box.max = portal.box.min + glm::vec3(1.0f);
+        room_portals[rooms[0]].push_back((int)portals.size());
+        room_portals[rooms[1]].push_back((int)portals.size());
+        portals.push_back(portal);
+    }
+
+    reached.assign(room_count, 0);
+    std::cout << "Portal culling: " << room_count << " rooms, " << portals.size() << " portals." << std::endl;
+}
+
+void PortalCulling::update(const glm::vec3& camera_position, const Frustum& frustum) {
+    std::fill(reached.begin(), reached.end(), 0);
+    rooms_reached = 0;
+    stack.clear();
+
+    glm::ivec2 camera_tile = tile_of(camera_position);
+    active = in_map(camera_tile);
+    if (active) {
+        // camera in a door tile starts in the rooms on both sides
+        for (int r : tile_rooms[camera_tile.y * cols + camera_tile.x]) {
+            if (r != NO_ROOM && !reached[r]) {
+                reached[r] = 1;
+                stack.push_back(r);
+            }
+        }
+        active = !stack.empty();
+    }
+    if (!active) {
+        // flying over walls or outside of the map
+        rooms_reached = room_count;
+        return;
+    }
+
+    while (!stack.empty()) {
+        int r = stack.back();
+        stack.pop_back();
+        rooms_reached++;
+        for (int p : room_portals[r]) {
+            const Portal& portal = portals[p];
+            if (portal.door->state == DoorState::Closed || !frustum.intersects(portal.box)) {
+                continue;
+            }
+            int other = portal.rooms[0] == r ? portal.rooms[1] : portal.rooms[0];
+            if (!reached[other]) {
+                reached[other] = 1;
+                stack.push_back(other);
+            }
+        }
+    }
+}
+
+bool PortalCulling::is_visible(const Model& model) const {
+    // large models (floor) span several rooms, same rule as SceneGrid
+    if (!active || Model::is_large(model.bounds())) {
+        return true;
+    }
+    glm::ivec2 tile = tile_of(model.origin);
+    if (!in_map(tile)) {
+        return true;
+    }
+    for (int r : tile_rooms[tile.y * cols + tile.x]) {
+        if (r != NO_ROOM && reached[r]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PortalCulling::clear() {
+    tile_rooms.clear();
+    room_portals.clear();
+    portals.clear();
+    reached.clear();
+    stack.clear();
+    cols = rows = 0;
+    room_count = 0;
+    rooms_reached = 0;
+    active = false;
+}
@@ -0,0 +1,84 @@
+#ifndef PORTALCULLING_HPP
+#define PORTALCULLING_HPP
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Door.hpp"
+#include "Frustum.hpp"
+#include "Map.hpp"
+#include "Model.hpp"
+
+/* Cell and portal occlusion culling on the tile map.
+ * At level load, open tiles are flood-filled into rooms (cells), door tiles become portals
+ * between the rooms on their two sides. Each frame the rooms visible from the camera are
+ * found by flood-filling from the camera room through portals whose door is not closed
+ * and which lie in the view frustum. Only models of reached rooms are drawn; walls and doors
+ * belong to all rooms next to them.
+ */
+class PortalCulling {
+public:
+    static constexpr int NO_ROOM = -1;
+
+    // statistics of the last update
+    int rooms_reached = 0;
+    int room_count = 0;
+
+    /* Derive rooms and portals from the map
+     * @param map: level map
+     * @param prototypes: token -> prototype model
+     * @param models: scene models (doors are taken from here)
+     * @param offset: map to world offset (same as used for placing models)
+     */
+    void build(Map& map, std::unordered_map<std::string, Model>& prototypes,
+               const std::vector<std::unique_ptr<Model>>& models, const glm::vec3& offset);
+
+    /* Flood-fill rooms visible from the camera
+     * @param camera_position: world position of the camera
+     * @param frustum: camera frustum
+     */
+    void update(const glm::vec3& camera_position, const Frustum& frustum);
+
+    /* Is the model in (or next to) a reached room?
+     * Models outside the map, large models and everything while the camera is outside
+     * of any room are visible.
+     * @param model: scene model
+     */
+    bool is_visible(const Model& model) const;
+
+    void clear();
+
+private:
+    struct Portal {
+        const Door* door;
+        glm::ivec2 tile;
+        std::array<int, 2> rooms;
+        AABB box;
+    };
+
+    int cols = 0;
+    int rows = 0;
+    glm::vec2 origin{ 0.0f };
+    bool active = false; // camera is inside a room
+
+    // rooms touching each tile (own room for open tiles, neighbours for walls and doors)
+    std::vector<std::array<int, 4>> tile_rooms;
+    std::vector<std::vector<int>> room_portals;
+    std::vector<Portal> portals;
+    std::vector<char> reached;
+    std::vector<int> stack;
+
+    glm::ivec2 tile_of(const glm::vec3& position) const {
+        return glm::ivec2(glm::floor(glm::vec2(position.x, position.z) - origin));
+    }
+    bool in_map(const glm::ivec2& tile) const {
+        return tile.x >= 0 && tile.y >= 0 && tile.x < cols && tile.y < rows;
+    }
+};
+
+#endif // PORTALCULLING_HPP
@@ -0,0 +1,163 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+
+uint64_t RenderQueue::make_key(Pass pass, GLuint shader, GLuint texture, GLuint mesh, float depth) {
+    const uint64_t depth_max = (1u << 20) - 1;
+    uint64_t d = (uint64_t)(glm::clamp(depth / MAX_DEPTH, 0.0f, 1.0f) * depth_max);
+    uint64_t s = shader & 0x3FF;
+    uint64_t t = texture & 0xFFFF;
+    uint64_t m = mesh & 0xFFFF;
+
+    if (pass == Pass::Transparent) {
+        // farthest first
+        return ((uint64_t)pass << 62) | ((depth_max - d) << 42) | (s << 32) | (t << 16) | m;
+    }
+    return ((uint64_t)pass << 62) | (s << 52) | (t << 36) | (m << 20) | d;
+}
+
+void RenderQueue::push(Pass pass, const Model& model, const glm::mat4& model_matrix, float depth, GLuint query) {
+    for (const auto& mesh : model.meshes) {
+        const auto& buffers = mesh.get_buffers();
+        if (!buffers || buffers->VAO == 0) {
+            continue;
+        }
+        Key key;
+        key.key = make_key(pass, mesh.shader.getID(), model.texture_id, buffers->VAO, depth);
+        key.item = (uint32_t)items.size();
+        keys.push_back(key);
+        items.push_back({ &mesh, model.texture_id, model_matrix, query });
+    }
+}
+
+void RenderQueue::radix_sort(size_t first) {
+    // LSD radix sort of keys[first, end), 8 bits per pass; bytes equal in all keys are skipped
+    auto begin = keys.begin() + first;
+    scratch.resize(keys.size() - first);
+    uint64_t all_or = 0, all_and = ~0ull;
+    for (auto it = begin; it != keys.end(); ++it) {
+        all_or |= it->key;
+        all_and &= it->key;
+    }
+    for (int shift = 0; shift < 64; shift += 8) {
+        if ((((all_or ^ all_and) >> shift) & 0xFF) == 0) {
+            continue;
+        }
+        size_t count[257] = { 0 };
+        for (auto it = begin; it != keys.end(); ++it) {
+            count[((it->key >> shift) & 0xFF) + 1]++;
+        }
+        for (int i = 0; i < 256; ++i) {
+            count[i + 1] += count[i];
+        }
+        for (auto it = begin; it != keys.end(); ++it) {
+            scratch[count[(it->key >> shift) & 0xFF]++] = *it;
+        }
+        std::copy(scratch.begin(), scratch.end(), begin);
+    }
+}
+
+std::vector<RenderQueue::Key>::const_iterator RenderQueue::first_of(Pass pass) {
+    if (sorted_count < keys.size()) {
+        // passes pushed after a submit are sorted on their own and merged into the sorted part
+        radix_sort(sorted_count);
+        std::inplace_merge(keys.begin(), keys.begin() + sorted_count, keys.end(),
+                           [](const Key& a, const Key& b) { return a.key < b.key; });
+        sorted_count = keys.size();
+    }
+
+    // items of one pass are contiguous
+    uint64_t pass_bits = (uint64_t)pass << 62;
+    return std::lower_bound(keys.cbegin(), keys.cend(), pass_bits,
+                            [](const Key& k, uint64_t value) { return k.key < value; });
+}
+
+int RenderQueue::submit_depth(Pass pass, ShaderProgram& depth_shader) {
+    GLuint current_VAO = (GLuint)-1;
+    int draw_calls = 0;
+
+    depth_shader.activate();
+    Uniform<glm::mat4> m_m = depth_shader.common().m_m;
+    for (auto it = first_of(pass); it != keys.cend() && (it->key >> 62) == (uint64_t)pass; ++it) {
+        const Item& item = items[it->item];
+        const MeshBuffers& buffers = *item.mesh->get_buffers();
+
+        m_m.set(item.model_matrix);
+        if (buffers.depth_VAO != current_VAO) {
+            current_VAO = buffers.depth_VAO;
+            glBindVertexArray(current_VAO);
+        }
+        glDrawElements(item.mesh->primitive_type, (GLsizei)buffers.indices.size(), GL_UNSIGNED_INT, 0);
+        draw_calls++;
+    }
+    glBindVertexArray(0);
+    return draw_calls;
+}
+
+int RenderQueue::submit(Pass pass, const std::function<void(ShaderProgram&)>& on_shader,
+                        ShaderProgram* shader_override) {
+    auto first = first_of(pass);
+
+    ShaderProgram* current_shader = nullptr;
+    GLuint current_texture = (GLuint)-1;
+    GLuint current_VAO = (GLuint)-1;
+    int draw_calls = 0;
+
+    glActiveTexture(GL_TEXTURE0);
+    for (auto it = first; it != keys.cend() && (it->key >> 62) == (uint64_t)pass; ++it) {
+        const Item& item = items[it->item];
+        const Mesh& mesh = *item.mesh;
+        const MeshBuffers& buffers = *mesh.get_buffers();
+
+        ShaderProgram* mesh_shader = shader_override ? shader_override : &mesh.shader;
+        if (mesh_shader != current_shader) {
+            current_shader = mesh_shader;
+            current_shader->activate();
+            current_shader->common().tex0.set(0);
+            if (on_shader) {
+                on_shader(*current_shader);
+            }
+            stats.shader_binds++;
+        } else {
+            stats.shader_binds_elided++;
+        }
+        const ShaderProgram::CommonUniforms& uniforms = current_shader->common();
+
+        uniforms.m_m.set(item.model_matrix);
+        if (uniforms.specular_shinines) {
+            uniforms.ambient_material.set(mesh.ambient_material);
+            uniforms.diffuse_material.set(mesh.diffuse_material);
+            uniforms.specular_material.set(mesh.specular_material);
+            uniforms.specular_shinines.set(mesh.reflectivity);
+        }
+
+        if (item.texture_id != current_texture) {
+            current_texture = item.texture_id;
+            glBindTexture(GL_TEXTURE_2D, current_texture);
+            stats.texture_binds++;
+        } else {
+            stats.texture_binds_elided++;
+        }
+
+        if (buffers.VAO != current_VAO) {
+            current_VAO = buffers.VAO;
+            glBindVertexArray(current_VAO);
+            stats.vao_binds++;
+        } else {
+            stats.vao_binds_elided++;
+        }
+
+        if (item.query != 0) {
+            // skipped on the GPU if the bounding box was hidden, never waits for the result
+            glBeginConditionalRender(item.query, GL_QUERY_NO_WAIT);
+        }
+        glDrawElements(mesh.primitive_type, (GLsizei)buffers.indices.size(), GL_UNSIGNED_INT, 0);
+        if (item.query != 0) {
+            glEndConditionalRender();
+        }
+        stats.items++;
+        draw_calls++;
+    }
+    glBindVertexArray(0);
+    return draw_calls;
+}
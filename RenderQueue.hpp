@@ -0,0 +1,101 @@
+#ifndef RENDERQUEUE_HPP
+#define RENDERQUEUE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.hpp"
+#include "Model.hpp"
+#include "ShaderProgram.hpp"
+
+/* Per-frame list of draw items sorted by a packed 64-bit key, submitted with
+ * redundant program, texture and VAO binds skipped.
+ *
+ * Key layout (most significant first):
+ *   opaque:      pass(2) | shader(10) | texture(16) | mesh(16) | depth(20)   - state first, front to back
+ *   cutout:      same as opaque (alpha tested, drawn after the opaque walls)
+ *   transparent: pass(2) | ~depth(20) | shader(10) | texture(16) | mesh(16)  - back to front first
+ */
+class RenderQueue {
+public:
+    enum class Pass : uint64_t {
+        Opaque = 0,
+        Transparent = 1,
+        Cutout = 2,
+    };
+
+    // depth is quantized over [0, MAX_DEPTH] world units
+    static constexpr float MAX_DEPTH = 1024.0f;
+
+    // statistics of the last submitted frame
+    struct Stats {
+        int items = 0;
+        int shader_binds = 0;
+        int shader_binds_elided = 0;
+        int texture_binds = 0;
+        int texture_binds_elided = 0;
+        int vao_binds = 0;
+        int vao_binds_elided = 0;
+    };
+    Stats stats;
+
+    // start a new frame
+    void clear() {
+        items.clear();
+        keys.clear();
+        sorted_count = 0;
+        stats = Stats();
+    }
+
+    /* Add all meshes of a model
+     * @param pass: render pass
+     * @param model: drawn model, texture is taken from it (as in Model::draw)
+     * @param model_matrix: final model matrix (local_model_matrix included)
+     * @param depth: distance from the camera
+     * @param query: occlusion query the draw is conditional on, 0 = always drawn
+     */
+    void push(Pass pass, const Model& model, const glm::mat4& model_matrix, float depth, GLuint query = 0);
+
+    /* Draw all items of one pass in key order
+     * @param pass: render pass
+     * @param on_shader: called after a program is bound (per-program uniforms)
+     * @param shader_override: program used instead of the mesh shaders (must accept the same vertex layout)
+     * @return: number of draw calls
+     */
+    int submit(Pass pass, const std::function<void(ShaderProgram&)>& on_shader = nullptr,
+               ShaderProgram* shader_override = nullptr);
+
+    /* Draw depth of all items of one pass from the position-only streams (MeshBuffers::depth_VAO)
+     * @param pass: render pass
+     * @param depth_shader: position-only program (depth.vert)
+     * @return: number of draw calls
+     */
+    int submit_depth(Pass pass, ShaderProgram& depth_shader);
+
+private:
+    struct Item {
+        const Mesh* mesh;
+        GLuint texture_id;
+        glm::mat4 model_matrix;
+        GLuint query;
+    };
+    struct Key {
+        uint64_t key;
+        uint32_t item;
+    };
+
+    std::vector<Item> items;
+    std::vector<Key> keys;
+    std::vector<Key> scratch;
+    size_t sorted_count = 0; // keys[0, sorted_count) are in order, later pushes are sorted and merged in
+
+    std::vector<Key>::const_iterator first_of(Pass pass);
+    static uint64_t make_key(Pass pass, GLuint shader, GLuint texture, GLuint mesh, float depth);
+    void radix_sort(size_t first);
+};
+
+#endif // RENDERQUEUE_HPP
@@ -0,0 +1,145 @@
+#include "RingBuffer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+void RingBuffer::init(GLsizeiptr frame_size) {
+    clear();
+
+    // offsets of glBindBufferRange have to be multiples of these
+    GLint uniform_alignment = 0;
+    GLint storage_alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+    default_alignment = std::max<GLsizeiptr>({ 16, uniform_alignment, storage_alignment });
+
+    create(frame_size);
+}
+
+void RingBuffer::create(GLsizeiptr frame_size) {
+    // regions start aligned
+    this->frame_size = (frame_size + default_alignment - 1) / default_alignment * default_alignment;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, this->frame_size * FRAMES, nullptr, flags);
+    mapped = static_cast<char*>(glMapNamedBufferRange(buffer, 0, this->frame_size * FRAMES, flags));
+    if (mapped == nullptr) {
+        throw std::runtime_error("Ring buffer could not be mapped.");
+    }
+    head = 0;
+}
+
+void RingBuffer::begin_frame() {
+    release_retired();
+
+    frame = (frame + 1) % FRAMES;
+    head = 0;
+    GLsync& fence = fences[frame];
+    if (fence == nullptr) {
+        return;
+    }
+
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        // the GPU still reads this region, nothing else to write to
+        stalls++;
+        GLenum status;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void RingBuffer::end_frame() {
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    fences[frame] = fence;
+    used = head;
+
+    // buffers replaced in this frame are done when this frame is
+    for (Retired& old : retired) {
+        if (old.fence == nullptr) {
+            old.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    }
+}
+
+RingBuffer::Allocation RingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) {
+    if (alignment == 0) {
+        alignment = default_alignment;
+    }
+    GLsizeiptr offset = (head + alignment - 1) / alignment * alignment;
+    if (offset + size > frame_size) {
+        grow(size + alignment);
+        offset = 0;
+    }
+    head = offset + size;
+
+    Allocation allocation;
+    allocation.buffer = buffer;
+    allocation.offset = frame * frame_size + offset;
+    allocation.size = size;
+    allocation.data = mapped + allocation.offset;
+    return allocation;
+}
+
+void RingBuffer::grow(GLsizeiptr needed) {
+    GLsizeiptr new_size = frame_size;
+    while (new_size < frame_size + needed) {
+        new_size *= 2;
+    }
+    grows++;
+    std::cout << "Ring buffer grows to " << new_size * FRAMES / 1024 << " KiB." << std::endl;
+
+    // draws issued so far still read the old buffer, it stays mapped until they finish
+    retired.push_back({ buffer, nullptr });
+    for (GLsync& fence : fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    create(new_size);
+}
+
+void RingBuffer::release_retired() {
+    retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                 [](Retired& old) {
+                                     if (old.fence == nullptr ||
+                                         glClientWaitSync(old.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+                                         return false;
+                                     }
+                                     glDeleteSync(old.fence);
+                                     glDeleteBuffers(1, &old.buffer);
+                                     return true;
+                                 }),
+                  retired.end());
+}
+
+void RingBuffer::clear() {
+    for (GLsync& fence : fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    for (Retired& old : retired) {
+        if (old.fence != nullptr) {
+            glDeleteSync(old.fence);
+        }
+        glDeleteBuffers(1, &old.buffer);
+    }
+    retired.clear();
+    if (buffer != 0) {
+        // deleting a buffer unmaps it
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    mapped = nullptr;
+    frame_size = 0;
+    frame = 0;
+    head = 0;
+    used = 0;
+}
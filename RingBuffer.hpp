@@ -0,0 +1,93 @@
+#ifndef RINGBUFFER_HPP
+#define RINGBUFFER_HPP
+
+#include <cstring>
+#include <vector>
+
+#include <GL/glew.h>
+
+/* Persistently mapped buffer for data written by the CPU every frame
+ * (instance attributes, uniform blocks...), replacing glBufferData re-specification.
+ * The buffer is split to FRAMES regions, each frame writes to the next one and
+ * fences it when done, so the CPU writes while the GPU still reads the older frames.
+ * The mapping is coherent, written bytes are visible to the following draw calls.
+ * Usage: begin_frame(), allocate() / push() and bind the returned offset, end_frame().
+ */
+class RingBuffer {
+public:
+    static constexpr int FRAMES = 3;
+
+    // part of the buffer for one draw
+    struct Allocation {
+        GLuint buffer = 0;    // bind this buffer (it changes when the ring grows)
+        GLintptr offset = 0;  // in bytes from the start of buffer
+        GLsizeiptr size = 0;
+        void* data = nullptr; // mapped memory to write to
+    };
+
+    // statistics
+    int stalls = 0;          // begin_frame() had to wait for the GPU, the ring is too short
+    int grows = 0;           // a frame did not fit and the buffer was reallocated
+    GLsizeiptr used = 0;     // bytes allocated in the last finished frame
+
+    RingBuffer() = default;
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+    ~RingBuffer() { clear(); }
+
+    /* Create and map the buffer
+     * @param frame_size: bytes available to one frame, doubled when exceeded
+     */
+    void init(GLsizeiptr frame_size);
+
+    /* Move to the next region, waits (and counts a stall) only if the GPU is FRAMES frames behind */
+    void begin_frame();
+
+    /* Fence the region written since begin_frame() */
+    void end_frame();
+
+    /* Reserve memory in the region of the current frame, valid until the region is reused
+     * @param size: bytes
+     * @param alignment: offset alignment, 0 = fits uniform and storage buffer bindings
+     * @return: buffer, offset and pointer for writing
+     */
+    Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 0);
+
+    /* Allocate and copy
+     * @param data: source
+     * @param size: bytes
+     * @param alignment: offset alignment, 0 = default (see allocate)
+     * @return: allocation holding the copy
+     */
+    Allocation push(const void* data, GLsizeiptr size, GLsizeiptr alignment = 0) {
+        Allocation allocation = allocate(size, alignment);
+        std::memcpy(allocation.data, data, size);
+        return allocation;
+    }
+
+    GLsizeiptr get_frame_size() const { return frame_size; }
+
+    void clear();
+
+private:
+    // replaced buffer, deleted once the GPU finished the frames using it
+    struct Retired {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+    };
+
+    GLuint buffer = 0;
+    char* mapped = nullptr;
+    GLsizeiptr frame_size = 0;
+    GLsizeiptr default_alignment = 16;
+    int frame = 0;           // current region
+    GLsizeiptr head = 0;     // next free byte in the current region
+    GLsync fences[FRAMES] = {};
+    std::vector<Retired> retired;
+
+    void create(GLsizeiptr frame_size);
+    void grow(GLsizeiptr needed);
+    void release_retired();
+};
+
+#endif // RINGBUFFER_HPP
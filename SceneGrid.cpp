@@ -0,0 +1,99 @@
+#include "SceneGrid.hpp"
+
+#include <cmath>
+
+void SceneGrid::build(const std::vector<std::unique_ptr<Model>>& models, unsigned version, int cols, int rows,
+                      const glm::vec2& origin) {
+    clear();
+    this->cols = cols;
+    this->rows = rows;
+    this->origin = origin;
+    block_cols = (cols + BLOCK - 1) / BLOCK;
+    block_rows = (rows + BLOCK - 1) / BLOCK;
+    tiles.resize((size_t)cols * rows);
+    blocks.resize((size_t)block_cols * block_rows);
+
+    for (const auto& model : models) {
+        Entry entry{ model.get(), model->bounds() };
+        if (!entry.box.valid()) {
+            continue;
+        }
+        const Door* door = dynamic_cast<const Door*>(model.get());
+        if (door != nullptr) {
+            // doors slide down while opening
+            AABB opened = entry.box;
+            opened.min.y -= door->open_distance;
+            entry.box.extend(opened);
+        }
+        glm::vec3 center = entry.box.center();
+        int x = (int)std::floor(center.x - origin.x);
+        int y = (int)std::floor(center.z - origin.y);
+        if (Model::is_large(entry.box) || x < 0 || y < 0 || x >= cols || y >= rows) {
+            large.push_back(entry);
+            continue;
+        }
+        Cell& tile = tiles[(size_t)y * cols + x];
+        tile.box.extend(entry.box);
+        tile.entries.push_back(entry);
+        Block& block = blocks[(size_t)(y / BLOCK) * block_cols + x / BLOCK];
+        block.box.extend(entry.box);
+        block.count++;
+    }
+
+    built = true;
+    built_version = version;
+}
+
+void SceneGrid::cull_entries(const Frustum& frustum, const std::vector<Entry>& entries,
+                             std::vector<Model*>& out) {
+    for (const auto& entry : entries) {
+        if (frustum.intersects(entry.box)) {
+            out.push_back(entry.model);
+            visible++;
+        }
+    }
+    total += (int)entries.size();
+}
+
+void SceneGrid::cull(const Frustum& frustum, std::vector<Model*>& out) {
+    visible = 0;
+    total = 0;
+
+    cull_entries(frustum, large, out);
+
+    for (int by = 0; by < block_rows; ++by) {
+        for (int bx = 0; bx < block_cols; ++bx) {
+            const Block& block = blocks[(size_t)by * block_cols + bx];
+            if (block.count == 0) {
+                continue;
+            }
+            if (!frustum.intersects(block.box)) {
+                total += block.count;
+                continue;
+            }
+            for (int y = by * BLOCK; y < glm::min(rows, (by + 1) * BLOCK); ++y) {
+                for (int x = bx * BLOCK; x < glm::min(cols, (bx + 1) * BLOCK); ++x) {
+                    const Cell& tile = tiles[(size_t)y * cols + x];
+                    if (tile.entries.empty()) {
+                        continue;
+                    }
+                    if (!frustum.intersects(tile.box)) {
+                        total += (int)tile.entries.size();
+                        continue;
+                    }
+                    cull_entries(frustum, tile.entries, out);
+                }
+            }
+        }
+    }
+}
+
+void SceneGrid::clear() {
+    tiles.clear();
+    blocks.clear();
+    large.clear();
+    cols = rows = block_cols = block_rows = 0;
+    built = false;
+    visible = 0;
+    total = 0;
+}
@@ -0,0 +1,86 @@
+#ifndef SCENEGRID_HPP
+#define SCENEGRID_HPP
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "Door.hpp"
+#include "Frustum.hpp"
+#include "Model.hpp"
+
+/* Map grid used as a coarse acceleration structure for frustum culling.
+ * Models are bucketed by the tile under their bounding box center, tiles are grouped
+ * into BLOCK x BLOCK blocks. Culling tests blocks, then tiles of visible blocks,
+ * then models of visible tiles. Models larger than Model::LARGE_SIZE tiles (floor) are kept
+ * in a separate list and always tested individually.
+ */
+class SceneGrid {
+public:
+    static constexpr int BLOCK = 8;
+
+    // statistics of the last cull
+    int visible = 0;
+    int total = 0;
+
+    /* Bucket all models, called when models were added or removed
+     * @param models: scene models
+     * @param version: see App::models_version
+     * @param cols, rows: map size
+     * @param origin: world xz of the tile (0, 0) corner
+     */
+    void build(const std::vector<std::unique_ptr<Model>>& models, unsigned version, int cols, int rows,
+               const glm::vec2& origin);
+
+    /* Build again with the map size of the last build
+     * @param models: scene models
+     * @param version: see App::models_version
+     */
+    void rebuild(const std::vector<std::unique_ptr<Model>>& models, unsigned version) {
+        int cols = this->cols, rows = this->rows;
+        glm::vec2 origin = this->origin;
+        build(models, version, cols, rows, origin);
+    }
+
+    bool is_built(unsigned version) const { return built && version == built_version; }
+
+    /* Collect models intersecting the frustum
+     * @param frustum: camera frustum
+     * @param out: visible models (appended)
+     */
+    void cull(const Frustum& frustum, std::vector<Model*>& out);
+
+    void clear();
+
+private:
+    struct Entry {
+        Model* model;
+        AABB box; // for doors the whole range of movement
+    };
+    struct Cell {
+        AABB box;
+        std::vector<Entry> entries;
+    };
+    struct Block {
+        AABB box;
+        int count = 0;
+    };
+
+    int cols = 0;
+    int rows = 0;
+    int block_cols = 0;
+    int block_rows = 0;
+    glm::vec2 origin{ 0.0f };
+    bool built = false;
+    unsigned built_version = 0;
+
+    std::vector<Cell> tiles;
+    std::vector<Block> blocks;
+    std::vector<Entry> large;
+
+    void cull_entries(const Frustum& frustum, const std::vector<Entry>& entries, std::vector<Model*>& out);
+};
+
+#endif // SCENEGRID_HPP
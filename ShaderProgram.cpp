@@ -1,34 +1,298 @@
 #include "ShaderProgram.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
 #include <iostream>
 #include <sstream>
 
+#include "Hash.hpp"
+
+namespace {
+    // binary cache file header
+    constexpr uint32_t BINARY_MAGIC = 0x42505347; // "GSPB"
+    constexpr uint32_t BINARY_VERSION = 1;
+
+    struct BinaryHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t format;   // GLenum from glGetProgramBinary
+        uint32_t size;     // bytes of the binary that follow
+        float compile_ms;  // time of the source compile, to report what the cache saves
+    };
+
+    constexpr UniformName M_M{ "m_m" };
+    constexpr UniformName TEX0{ "tex0" };
+    constexpr UniformName AMBIENT_MATERIAL{ "ambient_material" };
+    constexpr UniformName DIFFUSE_MATERIAL{ "diffuse_material" };
+    constexpr UniformName SPECULAR_MATERIAL{ "specular_material" };
+    constexpr UniformName SPECULAR_SHININES{ "specular_shinines" };
+}
+
+bool ShaderProgram::init_parallel_compile(void) {
+    if (GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // as many as the driver likes
+        parallel_compile = true;
+    } else if (GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        parallel_compile = true;
+    }
+    std::cout << "Parallel shader compile: " << (parallel_compile ? "yes" : "no") << std::endl;
+    return parallel_compile;
+}
+
 ShaderProgram::ShaderProgram(const std::filesystem::path& VS_file,
-                             const std::filesystem::path& FS_file) {
-    std::vector<GLuint> shader_ids;
+                             const std::filesystem::path& FS_file,
+                             const std::vector<std::string>& defines)
+    : VS_file(VS_file), FS_file(FS_file), defines(defines) {
+    auto start = std::chrono::steady_clock::now();
+    std::string VS_code = load_source(VS_file);
+    std::string FS_code = load_source(FS_file);
+    std::filesystem::path binary_path = binary_cache_path(VS_code, FS_code);
 
-    shader_ids.push_back(compile_shader(VS_file, GL_VERTEX_SHADER));
-    shader_ids.push_back(compile_shader(FS_file, GL_FRAGMENT_SHADER));
+    float compile_ms = 0.0f;
+    ID = load_binary(binary_path, compile_ms);
+    if (ID != 0) {
+        resolve_uniforms();
+        double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        binary_cache_hits++;
+        binary_cache_saved_ms += compile_ms - load_ms;
+        std::cout << "Shader program " << cache_key(VS_file.filename(), FS_file.filename(), defines)
+                  << " loaded from binary cache in " << load_ms << " ms, saved " << compile_ms - load_ms
+                  << " ms." << std::endl;
+        return;
+    }
 
-    ID = link_shader(shader_ids);
+    binary_cache_misses++;
+    begin_compile(VS_code, FS_code, binary_path);
 }
 
-/* Get location and write error to console */
-GLuint ShaderProgram::getUniformLocation(const std::string& name) {
-    // Check if the location is already cached
-    if (uniform_location_cache.find(name) != uniform_location_cache.end()) {
-        return uniform_location_cache[name];
+void ShaderProgram::begin_compile(const std::string& VS_code, const std::string& FS_code,
+                                  const std::filesystem::path& binary_path) {
+    discard_pending();
+    auto start = std::chrono::steady_clock::now();
+    pending.binary_path = binary_path;
+    pending.shaders[0] = compile_shader(VS_code, GL_VERTEX_SHADER);
+    pending.shaders[1] = compile_shader(FS_code, GL_FRAGMENT_SHADER);
+    pending.program = link_shader({ pending.shaders[0], pending.shaders[1] });
+    pending.issue_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ShaderProgram::reload(void) {
+    std::string VS_code, FS_code;
+    try {
+        VS_code = load_source(VS_file);
+        FS_code = load_source(FS_file);
+    } catch (const std::exception& e) {
+        // editor may still be writing the file, the watcher reports it again
+        std::cerr << "Shader reload skipped: " << e.what() << std::endl;
+        return;
+    }
+    begin_compile(VS_code, FS_code, binary_cache_path(VS_code, FS_code));
+}
+
+bool ShaderProgram::compile_ready(void) {
+    if (pending.program == 0 || !parallel_compile) {
+        return true;
+    }
+    GLint done = GL_FALSE;
+    glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &done);
+    return done != GL_FALSE;
+}
+
+bool ShaderProgram::finish_compile(void) {
+    if (pending.program == 0) {
+        return false;
+    }
+    bool first = ID == 0;
+    // status queries block until the driver is done, so only compile and link are timed,
+    // not the time the program waited for its first use
+    auto start = std::chrono::steady_clock::now();
+    bool compiled = check_shader(pending.shaders[0], VS_file) && check_shader(pending.shaders[1], FS_file);
+    bool linked = compiled && check_program(pending.program);
+    if (!linked) {
+        discard_pending();
+        if (first) {
+            throw std::runtime_error(compiled ? "Shader linking failed." : "Shader compilation failed.");
+        }
+        // keep drawing with the old program until the file is fixed
+        return false;
+    }
+
+    float compile_ms =
+        pending.issue_ms + std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (first) {
+        compile_ms_total += compile_ms;
+    }
+    std::filesystem::path binary_path = pending.binary_path;
+    for (GLuint shader_h : pending.shaders) {
+        glDeleteShader(shader_h);
+    }
+    GLuint program = pending.program;
+    pending = PendingCompile();
+
+    // swap in place, so every Mesh and renderer holding this ShaderProgram uses the new one
+    if (ID != 0) {
+        if (currently_used == ID) {
+            currently_used = 0;
+        }
+        glDeleteProgram(ID);
+    }
+    ID = program;
+    resolve_uniforms();
+
+    save_binary(binary_path, compile_ms);
+    return true;
+}
+
+void ShaderProgram::discard_pending(void) {
+    if (pending.program != 0) {
+        glDeleteProgram(pending.program);
+        for (GLuint shader_h : pending.shaders) {
+            glDeleteShader(shader_h);
+        }
+    }
+    pending = PendingCompile();
+}
+
+bool ShaderProgram::check_shader(const GLuint shader_h, const std::filesystem::path& source_file) {
+    GLint status;
+    glGetShaderiv(shader_h, GL_COMPILE_STATUS, &status);
+    if (status == GL_FALSE) {
+        std::cerr << "Error compiling shader: " << source_file << std::endl;
+        std::cerr << getShaderInfoLog(shader_h) << std::endl;
+        return false;
+    }
+    std::cout << "Shader compiled successfully." << std::endl;
+    return true;
+}
+
+bool ShaderProgram::check_program(const GLuint prog_h) {
+    GLint status;
+    glGetProgramiv(prog_h, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        std::cerr << "Error linking shader program." << std::endl;
+        std::cerr << getProgramInfoLog(prog_h) << std::endl;
+        return false;
+    }
+    std::cout << "Shader program linked successfully." << std::endl;
+    return true;
+}
+
+std::filesystem::path ShaderProgram::binary_cache_path(const std::string& VS_code, const std::string& FS_code) {
+    Hash hash;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const GLubyte* text = glGetString(name);
+        hash.add(text ? std::string(reinterpret_cast<const char*>(text)) : std::string());
+    }
+    hash.add(VS_code);
+    hash.add(FS_code);
+    return BINARY_CACHE_DIR / (hash.hex() + ".bin");
+}
+
+GLuint ShaderProgram::load_binary(const std::filesystem::path& path, float& compile_ms) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return 0;
+    }
+    BinaryHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != BINARY_MAGIC || header.version != BINARY_VERSION || header.size == 0) {
+        return 0;
+    }
+    std::vector<char> binary(header.size);
+    if (!file.read(binary.data(), binary.size())) {
+        return 0;
+    }
+
+    GLuint prog_h = glCreateProgram();
+    glProgramBinary(prog_h, header.format, binary.data(), (GLsizei)binary.size());
+    GLint status;
+    glGetProgramiv(prog_h, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        // driver update or a different GPU, compile from source and replace the file
+        std::cout << "Shader binary rejected by the driver: " << path << std::endl;
+        glDeleteProgram(prog_h);
+        return 0;
+    }
+    compile_ms = header.compile_ms;
+    return prog_h;
+}
+
+void ShaderProgram::save_binary(const std::filesystem::path& path, const float compile_ms) {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    GLint size = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (formats == 0 || size <= 0) {
+        return;
     }
 
-    // Get the location and cache it
-    auto loc = glGetUniformLocation(ID, name.c_str());
+    std::vector<char> binary(size);
+    GLenum format = 0;
+    glGetProgramBinary(ID, size, &size, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::ofstream file(path, std::ios::binary);
+    if (error || !file) {
+        std::cerr << "Shader binary cache not writable: " << path << std::endl;
+        return;
+    }
+    BinaryHeader header{ BINARY_MAGIC, BINARY_VERSION, format, (uint32_t)size, compile_ms };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), size);
+}
+
+void ShaderProgram::resolve_uniforms(void) {
+    uniform_locations.clear();
+    GLint count = 0, max_length = 0;
+    glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_length);
+    std::vector<char> name(max_length + 1);
+    for (GLint i = 0; i < count; ++i) {
+        glGetProgramResourceName(ID, GL_UNIFORM, i, (GLsizei)name.size(), nullptr, name.data());
+        GLint location = glGetProgramResourceLocation(ID, GL_UNIFORM, name.data());
+        if (location < 0) {
+            // member of a uniform block
+            continue;
+        }
+        // arrays are reported as "name[0]"
+        std::string text(name.data());
+        if (text.size() > 3 && text.compare(text.size() - 3, 3, "[0]") == 0) {
+            text.resize(text.size() - 3);
+        }
+        uniform_locations.emplace_back(Hash::of(text.c_str()), location);
+    }
+    std::sort(uniform_locations.begin(), uniform_locations.end());
+
+    common_uniforms.m_m = Uniform<glm::mat4>(ID, find_location(M_M.hash));
+    common_uniforms.tex0 = Uniform<int>(ID, find_location(TEX0.hash));
+    common_uniforms.ambient_material = Uniform<glm::vec3>(ID, find_location(AMBIENT_MATERIAL.hash));
+    common_uniforms.diffuse_material = Uniform<glm::vec3>(ID, find_location(DIFFUSE_MATERIAL.hash));
+    common_uniforms.specular_material = Uniform<glm::vec3>(ID, find_location(SPECULAR_MATERIAL.hash));
+    common_uniforms.specular_shinines = Uniform<float>(ID, find_location(SPECULAR_SHININES.hash));
+}
+
+GLint ShaderProgram::find_location(const uint64_t hash) const {
+    auto it = std::lower_bound(uniform_locations.begin(), uniform_locations.end(), std::make_pair(hash, GLint(-1)));
+    return it != uniform_locations.end() && it->first == hash ? it->second : -1;
+}
+
+bool ShaderProgram::hasUniform(const std::string& name) {
+    wait();
+    return find_location(Hash::of(name.c_str())) != -1;
+}
+
+/* Get location and write error to console */
+GLint ShaderProgram::getUniformLocation(const std::string& name) {
+    wait();
+    GLint loc = find_location(Hash::of(name.c_str()));
     if (loc == -1) {
         std::cerr << "No uniform with name: " << name << '\n';
-    } else {
-        uniform_location_cache[name] = loc;
     }
     return loc;
 }
@@ -36,32 +300,32 @@ GLuint ShaderProgram::getUniformLocation(const std::string& name) {
 // Define the setUniform methods here
 void ShaderProgram::setUniform(const std::string& name, const float val) {
     auto loc = getUniformLocation(name);
-    glUniform1f(loc, val);
+    Uniform<float>(ID, loc).set(val);
 }
 
 void ShaderProgram::setUniform(const std::string& name, const int val) {
     auto loc = getUniformLocation(name);
-    glUniform1i(loc, val);
+    Uniform<int>(ID, loc).set(val);
 }
 
 void ShaderProgram::setUniform(const std::string& name, const glm::vec3 val) {
     auto loc = getUniformLocation(name);
-    glUniform3fv(loc, 1, glm::value_ptr(val));
+    Uniform<glm::vec3>(ID, loc).set(val);
 }
 
 void ShaderProgram::setUniform(const std::string& name, const glm::vec4 val) {
     auto loc = getUniformLocation(name);
-    glUniform4fv(loc, 1, glm::value_ptr(val));
+    Uniform<glm::vec4>(ID, loc).set(val);
 }
 
 void ShaderProgram::setUniform(const std::string& name, const glm::mat3 val) {
     auto loc = getUniformLocation(name);
-    glUniformMatrix3fv(loc, 1, GL_FALSE, glm::value_ptr(val));
+    Uniform<glm::mat3>(ID, loc).set(val);
 }
 
 void ShaderProgram::setUniform(const std::string& name, const glm::mat4 val) {
     auto loc = getUniformLocation(name);
-    glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(val));
+    Uniform<glm::mat4>(ID, loc).set(val);
 }
 
 
@@ -89,52 +353,58 @@ std::string ShaderProgram::getProgramInfoLog(const GLuint obj) {
     return s;
 }
 
-GLuint ShaderProgram::compile_shader(const std::filesystem::path& source_file, const GLenum type) {
+/* Start compiling, the status is checked later in finish_compile */
+GLuint ShaderProgram::compile_shader(const std::string& source, const GLenum type) {
     GLuint shader_h = glCreateShader(type);
 
-    std::string shader_code = textFileRead(source_file);
-    const char* shader_code_cstr = shader_code.c_str();
+    const char* shader_code_cstr = source.c_str();
     glShaderSource(shader_h, 1, &shader_code_cstr, nullptr);
     glCompileShader(shader_h);
 
-    GLint status;
-    glGetShaderiv(shader_h, GL_COMPILE_STATUS, &status);
-    if (status == GL_FALSE) {
-        std::cerr << "Error compiling shader: " << source_file << std::endl;
-        std::cerr << getShaderInfoLog(shader_h) << std::endl;
-        glDeleteShader(shader_h);
-        throw std::runtime_error("Shader compilation failed.");
-    } else {
-        std::cout << "Shader compiled successfully." << std::endl;
-    }
-
     return shader_h;
 }
 
-/* Link all shader IDs to final program */
+/* Link all shader IDs to final program, the status is checked later in finish_compile */
 GLuint ShaderProgram::link_shader(const std::vector<GLuint> shader_ids) {
     GLuint prog_h = glCreateProgram();
 
     for (const auto& id : shader_ids) glAttachShader(prog_h, id);
 
+    // keep the binary retrievable for save_binary
+    glProgramParameteri(prog_h, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(prog_h);
 
-    GLint status;
-    glGetProgramiv(prog_h, GL_LINK_STATUS, &status);
-    if (status == GL_FALSE) {
-        std::cerr << "Error linking shader program." << std::endl;
-        std::cerr << getProgramInfoLog(prog_h) << std::endl;
-        glDeleteProgram(prog_h);
-        throw std::runtime_error("Shader linking failed.");
-    } else {
-		std::cout << "Shader program linked successfully." << std::endl;
-	}
+    return prog_h;
+}
 
-    for (const auto& id : shader_ids) {
-		glDeleteShader(id);
-	}
+std::string ShaderProgram::cache_key(const std::filesystem::path& VS_file, const std::filesystem::path& FS_file,
+                                     const std::vector<std::string>& defines) {
+    std::string key = VS_file.string() + FS_file.string();
+    for (const auto& define : defines) {
+        key += "|" + define;
+    }
+    return key;
+}
 
-    return prog_h;
+std::string ShaderProgram::load_source(const std::filesystem::path& filename) {
+    std::string source = textFileRead(filename);
+    if (defines.empty()) {
+        return source;
+    }
+
+    // #version has to stay the first statement, defines go right after it
+    size_t version = source.find("#version");
+    size_t insert_at = version == std::string::npos ? 0 : source.find('\n', version);
+    insert_at = insert_at == std::string::npos ? source.size() : insert_at + 1;
+    int next_line = 1 + (int)std::count(source.begin(), source.begin() + insert_at, '\n');
+
+    std::string injected;
+    for (const auto& define : defines) {
+        injected += "#define " + define + "\n";
+    }
+    // keep line numbers of compile errors matching the file
+    injected += "#line " + std::to_string(next_line) + "\n";
+    return source.insert(insert_at, injected);
 }
 
 std::string ShaderProgram::textFileRead(const std::filesystem::path& filename) {
@@ -6,16 +6,72 @@
 #include <string>
 #include <unordered_map>
 #include <filesystem>
+#include <chrono>
+#include <utility>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "Uniform.hpp"
+
 class ShaderProgram {
 public:
+	// linked programs are stored here as driver binaries (glGetProgramBinary)
+	inline static const std::filesystem::path BINARY_CACHE_DIR = "cache/shaders";
+	// statistics of all programs created so far
+	inline static int binary_cache_hits = 0;
+	inline static int binary_cache_misses = 0;
+	inline static double binary_cache_saved_ms = 0.0;
+	inline static double compile_ms_total = 0.0; // main thread time of the first compiles (cache misses)
+
+	/* Let the driver compile on its own threads (GL_KHR/ARB_parallel_shader_compile).
+	 * Call once after glewInit, before the first program is created.
+	 * @return: true if compiles run in parallel
+	 */
+	static bool init_parallel_compile(void);
+
 	// you can add more constructors for pipeline with GS, TS etc.
 	ShaderProgram(void) = default; //does nothing
-	ShaderProgram(const std::filesystem::path & VS_file, const std::filesystem::path & FS_file);
+	/* Start compiling, the program is linked on first use (see wait)
+	 * or earlier from the binary cache
+	 * @param defines: permutation, "NAME" or "NAME VALUE" inserted as #define after #version
+	 */
+	ShaderProgram(const std::filesystem::path & VS_file, const std::filesystem::path & FS_file,
+	              const std::vector<std::string> & defines = {});
+
+	/* Key of one permutation in a shader cache
+	 * @return: paths and defines joined to one string
+	 */
+	static std::string cache_key(const std::filesystem::path & VS_file, const std::filesystem::path & FS_file,
+	                             const std::vector<std::string> & defines = {});
 	bool hasUniform(const std::string& name); // <-- ADD THIS LINE
+
+	/* Block until the program from the constructor is linked (no-op once it is) */
+	void wait(void) {
+		if (ID == 0 && pending.program != 0)
+			finish_compile();
+	}
+
+	/* Recompile from the current files in the background, the old program stays in use
+	 * until finish_compile swaps the new one in
+	 */
+	void reload(void);
+	// a reload was started and is not finished yet
+	bool reload_pending(void) const { return ID != 0 && pending.program != 0; }
+	// pending compile can be finished without waiting for the driver
+	bool compile_ready(void);
+	/* Check the pending compile and swap it in
+	 * A failed first compile throws, a failed reload keeps the old program.
+	 * @return: true if the new program is in use
+	 */
+	bool finish_compile(void);
+	// is the program built from this file?
+	bool uses(const std::filesystem::path & file) const { return file == VS_file || file == FS_file; }
+	const std::filesystem::path & get_vertex_file(void) const { return VS_file; }
+	const std::filesystem::path & get_fragment_file(void) const { return FS_file; }
+	const std::vector<std::string> & get_defines(void) const { return defines; }
+
 	void activate(void) {
+        wait();
         if (ID==currently_used)
             return;
         else {
@@ -32,14 +88,36 @@ public:
 	/* deallocate shader program */
 	void clear(void) {
 		deactivate();
+		discard_pending();
 		glDeleteProgram(ID);
 		ID = 0;
 	}
 
-	GLuint getID(void) { return ID; }
+	GLuint getID(void) { wait(); return ID; }
+
+	// uniforms of the shared draw paths (Mesh, RenderQueue, StaticLevelMesh, ...), resolved after every link
+	struct CommonUniforms {
+		Uniform<glm::mat4> m_m;
+		Uniform<int> tex0;
+		Uniform<glm::vec3> ambient_material;
+		Uniform<glm::vec3> diffuse_material;
+		Uniform<glm::vec3> specular_material;
+		Uniform<float> specular_shinines; // only in lit shaders
+	};
+	const CommonUniforms& common(void) { wait(); return common_uniforms; }
+
+	/* Typed handle of an active uniform, looked up by the precomputed hash
+	 * @param name: constexpr UniformName
+	 * @return: handle, invalid if the program has no such uniform
+	 */
+	template <typename T>
+	Uniform<T> uniform(const UniformName& name) {
+		wait();
+		return Uniform<T>(ID, find_location(name.hash));
+	}
     
-    // set uniform according to name 
-    // https://docs.gl/gl4/glUniform
+    // set uniform according to name, hashes the name on every call - prefer common() or uniform()
+    // https://docs.gl/gl4/glProgramUniform
     void setUniform(const std::string & name, const float val);
     void setUniform(const std::string & name, const int val);
     void setUniform(const std::string & name, const glm::vec3 val);
@@ -48,17 +126,54 @@ public:
     void setUniform(const std::string & name, const glm::mat4 val);
     
 private:
+	// compile started by the constructor or reload, checked by finish_compile
+	struct PendingCompile {
+		GLuint program{0};
+		GLuint shaders[2]{0, 0}; // vertex, fragment
+		std::filesystem::path binary_path;
+		float issue_ms{0.0f}; // spent in glCompileShader/glLinkProgram calls, the wait is added by finish_compile
+	};
+
 	GLuint ID{0}; // default = 0, empty shader
 	static GLuint currently_used;
-	std::unordered_map<std::string, GLuint> uniform_location_cache;
+	inline static bool parallel_compile = false;
+	std::vector<std::pair<uint64_t, GLint>> uniform_locations; // name hash -> location, sorted
+	CommonUniforms common_uniforms;
+	std::filesystem::path VS_file;
+	std::filesystem::path FS_file;
+	std::vector<std::string> defines;
+	PendingCompile pending;
 
-	GLuint getUniformLocation(const std::string& name);
+	/* Issue compile and link without querying their status
+	 * @param binary_path: where finish_compile stores the binary
+	 */
+	void begin_compile(const std::string & VS_code, const std::string & FS_code, const std::filesystem::path & binary_path);
+	void discard_pending(void);
+	bool check_shader(const GLuint shader_h, const std::filesystem::path & source_file);
+	bool check_program(const GLuint prog_h);
+
+	// fill uniform_locations and common_uniforms from the linked program
+	void resolve_uniforms(void);
+	GLint find_location(const uint64_t hash) const;
+	GLint getUniformLocation(const std::string& name);
 	std::string getShaderInfoLog(const GLuint obj);
 	std::string getProgramInfoLog(const GLuint obj);
 
-	GLuint compile_shader(const std::filesystem::path & source_file, const GLenum type);
+	GLuint compile_shader(const std::string & source, const GLenum type);
 	GLuint link_shader(const std::vector<GLuint> shader_ids);
     std::string textFileRead(const std::filesystem::path & filename);
+	// source of the file with the permutation defines injected
+	std::string load_source(const std::filesystem::path & filename);
+
+	/* Cache key of a program: sources and the driver, binaries are not portable between drivers
+	 * @return: path of the cached binary
+	 */
+	static std::filesystem::path binary_cache_path(const std::string & VS_code, const std::string & FS_code);
+	/* @param compile_ms: source compile time stored with a valid binary
+	 * @return: linked program, 0 if there is no binary or the driver rejected it
+	 */
+	GLuint load_binary(const std::filesystem::path & path, float & compile_ms);
+	void save_binary(const std::filesystem::path & path, const float compile_ms);
 };
 
 #endif // SHADERPROGRAM_HPP
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "ShaderWatcher.hpp"
+
+#include <algorithm>
+
+void ShaderWatcher::start(const std::vector<std::filesystem::path>& files) {
+    stop();
+    times.clear();
+    changed.clear();
+    for (const auto& file : files) {
+        std::error_code error;
+        times[file] = std::filesystem::last_write_time(file, error);
+    }
+    running = true;
+    thread = std::thread(&ShaderWatcher::run, this);
+}
+
+std::vector<std::filesystem::path> ShaderWatcher::changes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::filesystem::path> result;
+    result.swap(changed);
+    return result;
+}
+
+void ShaderWatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void ShaderWatcher::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        wake.wait_for(lock, INTERVAL, [this] { return !running; });
+        if (!running) {
+            break;
+        }
+
+        // file system calls without the lock, changes() must not wait for the disk
+        lock.unlock();
+        std::vector<std::filesystem::path> modified;
+        for (auto& [file, time] : times) {
+            std::error_code error;
+            auto now = std::filesystem::last_write_time(file, error);
+            if (!error && now != time) {
+                time = now;
+                modified.push_back(file);
+            }
+        }
+        lock.lock();
+
+        for (const auto& file : modified) {
+            if (std::find(changed.begin(), changed.end(), file) == changed.end()) {
+                changed.push_back(file);
+            }
+        }
+    }
+}
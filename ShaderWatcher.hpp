@@ -0,0 +1,48 @@
+#ifndef SHADERWATCHER_HPP
+#define SHADERWATCHER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Watches shader files for changes on a background thread.
+ * The thread only compares modification times, the main thread picks up
+ * the changed files with changes() and recompiles them (see App::update_shaders).
+ */
+class ShaderWatcher {
+public:
+    static constexpr std::chrono::milliseconds INTERVAL{ 250 };
+
+    ShaderWatcher() = default;
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+    ~ShaderWatcher() { stop(); }
+
+    /* Start watching, replaces the previously watched files
+     * @param files: shader source files
+     */
+    void start(const std::vector<std::filesystem::path>& files);
+
+    /* Files modified since the last call, each reported once
+     * @return: changed files
+     */
+    std::vector<std::filesystem::path> changes();
+
+    void stop();
+
+private:
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running = false;
+    std::map<std::filesystem::path, std::filesystem::file_time_type> times; // owned by the thread while running
+    std::vector<std::filesystem::path> changed; // guarded by mutex
+
+    void run();
+};
+
+#endif // SHADERWATCHER_HPP
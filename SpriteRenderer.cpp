@@ -0,0 +1,90 @@
+#include "SpriteRenderer.hpp"
+
+#include <algorithm>
+
+void SpriteRenderer::init(ShaderProgram& shader, ShaderProgram& oit_shader, ShaderProgram& cutout_shader,
+                          const std::shared_ptr<MeshBuffers>& quad, RingBuffer& stream) {
+    clear();
+    this->shader = &shader;
+    this->oit_shader = &oit_shader;
+    this->cutout_shader = &cutout_shader;
+    this->quad = quad;
+    this->stream = &stream;
+
+    glCreateVertexArrays(1, &VAO);
+
+    // binding 0: quad vertices
+    glVertexArrayVertexBuffer(VAO, 0, quad->VBO, 0, sizeof(Vertex));
+    glVertexArrayElementBuffer(VAO, quad->EBO);
+
+    glEnableVertexArrayAttrib(VAO, 0);
+    glVertexArrayAttribFormat(VAO, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+    glVertexArrayAttribBinding(VAO, 0, 0);
+
+    glEnableVertexArrayAttrib(VAO, 1);
+    glVertexArrayAttribFormat(VAO, 1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
+    glVertexArrayAttribBinding(VAO, 1, 0);
+
+    glEnableVertexArrayAttrib(VAO, 2);
+    glVertexArrayAttribFormat(VAO, 2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords));
+    glVertexArrayAttribBinding(VAO, 2, 0);
+
+    // binding 1: one vec4 per sprite, buffer range from the ring is set in flush()
+    glVertexArrayBindingDivisor(VAO, 1, 1);
+    glEnableVertexArrayAttrib(VAO, 3);
+    glVertexArrayAttribFormat(VAO, 3, 4, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(VAO, 3, 1);
+}
+
+void SpriteRenderer::flush(const glm::vec3& camera_position, Mode mode) {
+    draw_calls = 0;
+    instances = 0;
+    if (VAO == 0) {
+        return;
+    }
+
+    ShaderProgram& program = mode == Mode::OIT ? *oit_shader : mode == Mode::Cutout ? *cutout_shader : *shader;
+    program.activate();
+    program.common().tex0.set(0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(VAO);
+
+    glm::vec2 camera(camera_position.x, camera_position.z);
+    for (auto& [texture_array, sprites] : batches) {
+        if (sprites.empty()) {
+            continue;
+        }
+        if (mode == Mode::Blended) {
+            // blending needs back to front order
+            std::sort(sprites.begin(), sprites.end(), [&](const glm::vec4& a, const glm::vec4& b) {
+                glm::vec2 da = glm::vec2(a.x, a.z) - camera;
+                glm::vec2 db = glm::vec2(b.x, b.z) - camera;
+                return glm::dot(da, da) > glm::dot(db, db);
+            });
+        }
+
+        RingBuffer::Allocation instance_data = stream->push(sprites.data(), sprites.size() * sizeof(glm::vec4));
+        glVertexArrayVertexBuffer(VAO, 1, instance_data.buffer, instance_data.offset, sizeof(glm::vec4));
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture_array);
+        glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)quad->indices.size(), GL_UNSIGNED_INT, 0,
+                                (GLsizei)sprites.size());
+
+        draw_calls++;
+        instances += (int)sprites.size();
+        sprites.clear();
+    }
+    glBindVertexArray(0);
+}
+
+void SpriteRenderer::clear() {
+    if (VAO != 0) {
+        glDeleteVertexArrays(1, &VAO);
+        VAO = 0;
+    }
+    quad.reset();
+    stream = nullptr;
+    batches.clear();
+    shader = nullptr;
+    oit_shader = nullptr;
+    cutout_shader = nullptr;
+}
@@ -0,0 +1,81 @@
+#ifndef SPRITERENDERER_HPP
+#define SPRITERENDERER_HPP
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "MeshBuffers.hpp"
+#include "Model.hpp"
+#include "RingBuffer.hpp"
+#include "ShaderProgram.hpp"
+
+/* Camera facing sprites drawn with one instanced call per sprite texture array.
+ * Each sprite is a single vec4 (world position, layer), the quad is turned
+ * to the camera in sprite_billboard.vert, so no matrices are built on the CPU.
+ * Usage per frame: submit() sprites, then flush() in the pass they belong to
+ * (cutout sprites in the opaque pass, blended ones in the transparent pass).
+ */
+class SpriteRenderer {
+public:
+    enum class Mode {
+        Blended, // sorted back to front
+        OIT,     // any order, into WeightedOIT targets
+        Cutout,  // alpha tested, depth writes on
+    };
+
+    // statistics of the last flush()
+    int draw_calls = 0;
+    int instances = 0;
+
+    SpriteRenderer() = default;
+    SpriteRenderer(const SpriteRenderer&) = delete;
+    SpriteRenderer& operator=(const SpriteRenderer&) = delete;
+    ~SpriteRenderer() { clear(); }
+
+    // sprites packed in a texture array with no extra transformation
+    static bool accepts(const Model& model) {
+        return model.isSprite && model.texture_array_id != 0 && model.scale == glm::vec3(1.0f) &&
+               model.orientation == glm::vec3(0.0f) && model.local_model_matrix == glm::mat4(1.0f);
+    }
+
+    /* @param shader: sprite_billboard.vert + sprite_array.frag
+     * @param oit_shader: sprite_billboard.vert + sprite_array_oit.frag (see WeightedOIT)
+     * @param cutout_shader: sprite_billboard.vert + sprite_array.frag with ALPHA_TEST 1
+     * @param quad: sprite mesh (unit quad facing +Z)
+     * @param stream: per-frame ring the instance data is written to
+     */
+    void init(ShaderProgram& shader, ShaderProgram& oit_shader, ShaderProgram& cutout_shader,
+              const std::shared_ptr<MeshBuffers>& quad, RingBuffer& stream);
+
+    /* Add sprite to the batch of its texture array
+     * @param model: sprite accepted by accepts()
+     */
+    void submit(const Model& model) {
+        batches[model.texture_array_id].push_back(glm::vec4(model.origin, (float)model.texture_layer));
+    }
+
+    /* Upload and draw all submitted sprites, blended ones sorted back to front.
+     * Blending and depth state has to be set by the caller.
+     * @param camera_position: world position of the camera
+     * @param mode: shader and ordering of the pass
+     */
+    void flush(const glm::vec3& camera_position, Mode mode = Mode::Blended);
+
+    void clear();
+
+private:
+    ShaderProgram* shader = nullptr;
+    ShaderProgram* oit_shader = nullptr;
+    ShaderProgram* cutout_shader = nullptr;
+    std::shared_ptr<MeshBuffers> quad;
+    RingBuffer* stream = nullptr;
+    GLuint VAO = 0;
+    // texture array -> sprites, kept across frames to reuse the memory
+    std::map<GLuint, std::vector<glm::vec4>> batches;
+};
+
+#endif // SPRITERENDERER_HPP
@@ -0,0 +1,186 @@
+#include "StaticLevelMesh.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <map>
+
+void StaticLevelMesh::build(Map& map, std::unordered_map<std::string, Model>& prototypes,
+                            const glm::vec3& offset) {
+    clear();
+
+    // token of a static tile, empty string otherwise
+    auto static_token = [&](int x, int y) -> std::string {
+        if (map.outOfBounds(x, y)) {
+            return "";
+        }
+        std::string token = std::string(1, map.fetchMapValue(x, y));
+        auto it = prototypes.find(token);
+        if (it == prototypes.end() || !is_static(it->second)) {
+            return "";
+        }
+        return token;
+    };
+
+    // token -> vertices of its exposed faces (ordered, so the result is deterministic)
+    std::map<std::string, std::vector<Vertex>> faces;
+
+    for (int j = 0; j < map.getRows(); j++) {
+        for (int i = 0; i < map.getCols(); i++) {
+            std::string token = static_token(i, j);
+            if (token.empty()) {
+                continue;
+            }
+            Model tile = prototypes[token];
+            tile.origin = glm::vec3(i, 0, j) + offset;
+            glm::mat4 model_matrix = tile.local_model_matrix * tile.compute_model_matrix();
+            glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(model_matrix)));
+
+            if (shader == nullptr) {
+                shader = &tile.meshes[0].shader;
+            }
+
+            const std::vector<Vertex>& vertices = tile.meshes[0].get_buffers()->vertices;
+            for (size_t v = 0; v + 2 < vertices.size(); v += 3) {
+                faces_total++;
+                glm::vec3 normal = glm::normalize(normal_matrix * vertices[v].Normal);
+
+                // neighbour tile behind the face
+                bool hidden = false;
+                glm::vec3 n = glm::abs(normal);
+                if (n.y >= n.x && n.y >= n.z) {
+                    // bottom face stands on the floor, top face stays (visible in fly mode)
+                    hidden = normal.y < 0.0f;
+                } else if (n.x >= n.z) {
+                    hidden = !static_token(i + (normal.x > 0.0f ? 1 : -1), j).empty();
+                } else {
+                    hidden = !static_token(i, j + (normal.z > 0.0f ? 1 : -1)).empty();
+                }
+                if (hidden) {
+                    continue;
+                }
+
+                for (size_t k = v; k < v + 3; ++k) {
+                    Vertex vertex = vertices[k];
+                    vertex.Position = glm::vec3(model_matrix * glm::vec4(vertices[k].Position, 1.0f));
+                    vertex.Normal = glm::normalize(normal_matrix * vertices[k].Normal);
+                    faces[token].push_back(vertex);
+                }
+                faces_emitted++;
+            }
+        }
+    }
+
+    // merge all tokens into one vertex/index buffer, one section per token
+    std::vector<Vertex> vertex_data;
+    std::vector<GLuint> index_data;
+    for (auto& [token, vertices] : faces) {
+        const Model& prototype = prototypes[token];
+        const Mesh& mesh = prototype.meshes[0];
+
+        Section section;
+        section.token = token;
+        section.texture_id = prototype.texture_id;
+        section.ambient_material = mesh.ambient_material;
+        section.diffuse_material = mesh.diffuse_material;
+        section.specular_material = mesh.specular_material;
+        section.reflectivity = mesh.reflectivity;
+        section.first_index = (GLsizei)index_data.size();
+        section.index_count = (GLsizei)vertices.size();
+        sections.push_back(section);
+
+        for (auto& vertex : vertices) {
+            index_data.push_back((GLuint)vertex_data.size());
+            vertex_data.push_back(vertex);
+        }
+    }
+
+    if (!vertex_data.empty()) {
+        buffers = std::make_shared<MeshBuffers>(vertex_data, index_data);
+    }
+
+    std::cout << "Static level baked: " << faces_emitted << " of " << faces_total
+              << " triangles emitted, " << sections.size() << " sections." << std::endl;
+}
+
+int StaticLevelMesh::draw(ShaderProgram* shader_override) const {
+    if (!buffers || shader == nullptr) {
+        return 0;
+    }
+    ShaderProgram* shader = shader_override ? shader_override : this->shader;
+    shader->activate();
+    const ShaderProgram::CommonUniforms& uniforms = shader->common();
+    // vertices are already in world space
+    uniforms.m_m.set(glm::mat4(1.0f));
+    uniforms.tex0.set(0);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(buffers->VAO);
+    for (const auto& section : sections) {
+        uniforms.ambient_material.set(section.ambient_material);
+        uniforms.diffuse_material.set(section.diffuse_material);
+        uniforms.specular_material.set(section.specular_material);
+        uniforms.specular_shinines.set(section.reflectivity);
+        glBindTexture(GL_TEXTURE_2D, section.texture_id);
+
+        glDrawElements(GL_TRIANGLES, section.index_count, GL_UNSIGNED_INT,
+                       (void*)(section.first_index * sizeof(GLuint)));
+    }
+    glBindVertexArray(0);
+    return (int)sections.size();
+}
+
+int StaticLevelMesh::draw_depth(ShaderProgram& depth_shader) const {
+    if (!buffers) {
+        return 0;
+    }
+    depth_shader.activate();
+    // vertices are already in world space
+    depth_shader.common().m_m.set(glm::mat4(1.0f));
+
+    // sections are consecutive ranges of one index buffer
+    glBindVertexArray(buffers->depth_VAO);
+    glDrawElements(GL_TRIANGLES, (GLsizei)buffers->indices.size(), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+    return 1;
+}
+
+int StaticLevelMesh::draw_lightmapped(ShaderProgram& lightmap_shader, GLuint lightmap) const {
+    if (!buffers || lightmap_VBO == 0) {
+        return 0;
+    }
+    lightmap_shader.activate();
+    // vertices are already in world space
+    static constexpr UniformName LIGHTMAP{ "lightmap" };
+    lightmap_shader.common().m_m.set(glm::mat4(1.0f));
+    lightmap_shader.common().tex0.set(0);
+    lightmap_shader.uniform<int>(LIGHTMAP).set(1);
+    glBindTextureUnit(1, lightmap);
+    glActiveTexture(GL_TEXTURE0);
+
+    // materials are baked into the lightmap, only the texture changes
+    glBindVertexArray(buffers->VAO);
+    for (const auto& section : sections) {
+        glBindTexture(GL_TEXTURE_2D, section.texture_id);
+        glDrawElements(GL_TRIANGLES, section.index_count, GL_UNSIGNED_INT,
+                       (void*)(section.first_index * sizeof(GLuint)));
+    }
+    glBindVertexArray(0);
+    glBindTextureUnit(1, 0);
+    return (int)sections.size();
+}
+
+void StaticLevelMesh::set_lightmap_uvs(const std::vector<glm::vec2>& uvs) {
+    if (!buffers || uvs.size() != buffers->vertices.size()) {
+        return;
+    }
+    if (lightmap_VBO == 0) {
+        glCreateBuffers(1, &lightmap_VBO);
+    }
+    glNamedBufferData(lightmap_VBO, uvs.size() * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
+
+    // own binding point, attributes 0-2 keep their bindings from MeshBuffers
+    glVertexArrayVertexBuffer(buffers->VAO, 3, lightmap_VBO, 0, sizeof(glm::vec2));
+    glEnableVertexArrayAttrib(buffers->VAO, 3);
+    glVertexArrayAttribFormat(buffers->VAO, 3, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(buffers->VAO, 3, 3);
+}
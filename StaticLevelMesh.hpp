@@ -0,0 +1,107 @@
+#ifndef STATICLEVELMESH_HPP
+#define STATICLEVELMESH_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Map.hpp"
+#include "MeshBuffers.hpp"
+#include "Model.hpp"
+#include "ShaderProgram.hpp"
+
+/* Static level geometry baked from the Map grid into a single VBO.
+ * Only wall faces that can be seen are emitted: faces between two static walls
+ * and bottom faces standing on the floor are dropped. Faces are grouped per token,
+ * so each texture/material is one range of the shared index buffer.
+ * Doors, end-level tiles and other dynamic tokens are not baked.
+ */
+class StaticLevelMesh {
+public:
+    // range of the index buffer drawn with one texture and material
+    struct Section {
+        std::string token;
+        GLuint texture_id{ 0 };
+        glm::vec3 ambient_material{ 0.0f };
+        glm::vec3 diffuse_material{ 0.0f };
+        glm::vec3 specular_material{ 0.0f };
+        float reflectivity{ 0.0f };
+        GLsizei first_index{ 0 };
+        GLsizei index_count{ 0 };
+    };
+
+    // bake statistics
+    int faces_total = 0;
+    int faces_emitted = 0;
+
+    /* Can tiles of this prototype be merged into static geometry?
+     * @param prototype: model from map_2_model_dict
+     */
+    static bool is_static(const Model& prototype) {
+        return !prototype.isSprite && !prototype.transparent && !prototype.isDoor &&
+               !prototype.end_level && !prototype.collectible && !prototype.isEnemy &&
+               !prototype.light_source;
+    }
+
+    /* Walk the map once and bake all static wall tiles
+     * @param map: level map
+     * @param prototypes: token -> prototype model
+     * @param offset: map to world offset (same as used for placing models)
+     */
+    void build(Map& map, std::unordered_map<std::string, Model>& prototypes, const glm::vec3& offset);
+
+    /* Draw all sections, light uniforms have to be set by the caller
+     * @param shader_override: program used instead of the baked one (G-buffer pass)
+     * @return: number of draw calls
+     */
+    int draw(ShaderProgram* shader_override = nullptr) const;
+
+    /* Draw all faces at once from the position-only stream
+     * @param depth_shader: position-only program (depth.vert)
+     * @return: number of draw calls
+     */
+    int draw_depth(ShaderProgram& depth_shader) const;
+
+    /* Draw all sections lit only by a baked lightmap (see LightmapBaker)
+     * @param lightmap_shader: lightmap.vert + lightmap.frag
+     * @param lightmap: atlas texture, addressed by the coordinates from set_lightmap_uvs
+     * @return: number of draw calls
+     */
+    int draw_lightmapped(ShaderProgram& lightmap_shader, GLuint lightmap) const;
+
+    /* Attach lightmap coordinates as vertex attribute 3
+     * @param uvs: one coordinate per vertex of get_buffers()
+     */
+    void set_lightmap_uvs(const std::vector<glm::vec2>& uvs);
+
+    void clear() {
+        if (lightmap_VBO != 0) {
+            glDeleteBuffers(1, &lightmap_VBO);
+            lightmap_VBO = 0;
+        }
+        buffers.reset();
+        sections.clear();
+        shader = nullptr;
+        faces_total = 0;
+        faces_emitted = 0;
+    }
+
+    bool empty() const { return !buffers; }
+    ShaderProgram* get_shader() const { return shader; }
+    // world space triangles, three consecutive vertices each
+    const std::shared_ptr<MeshBuffers>& get_buffers() const { return buffers; }
+    const std::vector<Section>& get_sections() const { return sections; }
+    bool has_lightmap_uvs() const { return lightmap_VBO != 0; }
+
+private:
+    std::shared_ptr<MeshBuffers> buffers;
+    std::vector<Section> sections;
+    ShaderProgram* shader = nullptr;
+    GLuint lightmap_VBO{ 0 };
+};
+
+#endif // STATICLEVELMESH_HPP
@@ -0,0 +1,64 @@
+#ifndef UNIFORM_HPP
+#define UNIFORM_HPP
+
+#include <cstdint>
+#include <type_traits>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Hash.hpp"
+
+/* Uniform name hashed at compile time when declared constexpr:
+ *   static constexpr UniformName INV_P_M{ "inv_p_m" };
+ */
+struct UniformName {
+    uint64_t hash;
+    const char* text;
+
+    constexpr explicit UniformName(const char* text) : hash(Hash::of(text)), text(text) {}
+};
+
+/* Location of one uniform resolved after linking, set with glProgramUniform*,
+ * so the program does not have to be active. A missing uniform (location -1) is ignored.
+ * Handles become stale when the program is relinked (hot reload), keep them only
+ * for the duration of a draw call sequence or take them from ShaderProgram::common().
+ */
+template <typename T>
+class Uniform {
+public:
+    Uniform() = default;
+    Uniform(GLuint program, GLint location) : program(program), location(location) {}
+
+    explicit operator bool() const { return location >= 0; }
+
+    void set(const T& value) const {
+        if (location < 0) {
+            return;
+        }
+        if constexpr (std::is_same_v<T, float>) {
+            glProgramUniform1f(program, location, value);
+        } else if constexpr (std::is_same_v<T, int>) {
+            glProgramUniform1i(program, location, value);
+        } else if constexpr (std::is_same_v<T, glm::vec2>) {
+            glProgramUniform2fv(program, location, 1, glm::value_ptr(value));
+        } else if constexpr (std::is_same_v<T, glm::vec3>) {
+            glProgramUniform3fv(program, location, 1, glm::value_ptr(value));
+        } else if constexpr (std::is_same_v<T, glm::vec4>) {
+            glProgramUniform4fv(program, location, 1, glm::value_ptr(value));
+        } else if constexpr (std::is_same_v<T, glm::mat3>) {
+            glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, glm::value_ptr(value));
+        } else if constexpr (std::is_same_v<T, glm::mat4>) {
+            glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, glm::value_ptr(value));
+        } else {
+            static_assert(sizeof(T) == 0, "Uniform type not supported");
+        }
+    }
+
+private:
+    GLuint program{ 0 };
+    GLint location{ -1 };
+};
+
+#endif // UNIFORM_HPP
@@ -0,0 +1,98 @@
+#include "WeightedOIT.hpp"
+
+#include <stdexcept>
+
+void WeightedOIT::create_targets(int width, int height) {
+    delete_targets();
+    this->width = width;
+    this->height = height;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &accum_texture);
+    glTextureStorage2D(accum_texture, 1, GL_RGBA16F, width, height);
+    glCreateTextures(GL_TEXTURE_2D, 1, &revealage_texture);
+    glTextureStorage2D(revealage_texture, 1, GL_R8, width, height);
+    for (GLuint texture : { accum_texture, revealage_texture }) {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    // same format as the default framebuffer, so the opaque depth can be blitted
+    glCreateRenderbuffers(1, &depth_buffer);
+    glNamedRenderbufferStorage(depth_buffer, GL_DEPTH24_STENCIL8, width, height);
+
+    glCreateFramebuffers(1, &FBO);
+    glNamedFramebufferTexture(FBO, GL_COLOR_ATTACHMENT0, accum_texture, 0);
+    glNamedFramebufferTexture(FBO, GL_COLOR_ATTACHMENT1, revealage_texture, 0);
+    glNamedFramebufferRenderbuffer(FBO, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_buffer);
+    const GLenum draw_buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glNamedFramebufferDrawBuffers(FBO, 2, draw_buffers);
+
+    if (glCheckNamedFramebufferStatus(FBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw std::runtime_error("OIT framebuffer is not complete.");
+    }
+}
+
+void WeightedOIT::begin(int width, int height, GLuint depth_source) {
+    if (FBO == 0 || width != this->width || height != this->height) {
+        create_targets(width, height);
+    }
+
+    glBlitNamedFramebuffer(depth_source, FBO, 0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    const GLfloat zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat one[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glClearNamedFramebufferfv(FBO, GL_COLOR, 0, zero);
+    glClearNamedFramebufferfv(FBO, GL_COLOR, 1, one);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glEnable(GL_BLEND);
+    glBlendFunci(0, GL_ONE, GL_ONE);
+    glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+}
+
+void WeightedOIT::composite(GLuint target) {
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+    // weighted average over the opaque image, (1 - revealage) is the total coverage
+    glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+
+    composite_shader->activate();
+    glBindTextureUnit(0, accum_texture);
+    glBindTextureUnit(1, revealage_texture);
+    static constexpr UniformName ACCUM{ "accum" };
+    static constexpr UniformName REVEALAGE{ "revealage" };
+    composite_shader->uniform<int>(ACCUM).set(0);
+    composite_shader->uniform<int>(REVEALAGE).set(1);
+    glBindVertexArray(empty_VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    // back to the state set in App::init_glfw and expected by the following passes
+    glEnable(GL_DEPTH_TEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_CULL_FACE);
+}
+
+void WeightedOIT::delete_targets() {
+    if (FBO != 0) {
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteTextures(1, &accum_texture);
+        glDeleteTextures(1, &revealage_texture);
+        glDeleteRenderbuffers(1, &depth_buffer);
+        FBO = accum_texture = revealage_texture = depth_buffer = 0;
+    }
+    width = height = 0;
+}
+
+void WeightedOIT::clear() {
+    delete_targets();
+    if (empty_VAO != 0) {
+        glDeleteVertexArrays(1, &empty_VAO);
+        empty_VAO = 0;
+    }
+    composite_shader = nullptr;
+}
@@ -0,0 +1,60 @@
+#ifndef WEIGHTEDOIT_HPP
+#define WEIGHTEDOIT_HPP
+
+#include <GL/glew.h>
+
+#include "ShaderProgram.hpp"
+
+/* Weighted blended order-independent transparency (McGuire & Bavoil 2013).
+ * Transparent surfaces are drawn in any order into two targets:
+ *   accumulation (RGBA16F) += (premultiplied color, alpha) * weight(depth, alpha)
+ *   revealage    (R8)      *= 1 - alpha
+ * and a fullscreen pass composites the weighted average over the opaque image.
+ * Depth of the opaque pass is copied in, so hidden transparent fragments are rejected.
+ * Fragment shaders for this pass write layout(location = 0) accum, (location = 1) revealage
+ * (see *_oit.frag).
+ */
+class WeightedOIT {
+public:
+    WeightedOIT() = default;
+    WeightedOIT(const WeightedOIT&) = delete;
+    WeightedOIT& operator=(const WeightedOIT&) = delete;
+    ~WeightedOIT() { clear(); }
+
+    /* @param composite_shader: oit_composite.vert + oit_composite.frag
+     */
+    void init(ShaderProgram& composite_shader) {
+        clear();
+        this->composite_shader = &composite_shader;
+        glCreateVertexArrays(1, &empty_VAO);
+    }
+
+    /* Copy opaque depth, clear the targets and set blending for the accumulation pass
+     * @param width: framebuffer width
+     * @param height: framebuffer height
+     * @param depth_source: framebuffer holding the opaque depth, 0 = default framebuffer
+     */
+    void begin(int width, int height, GLuint depth_source = 0);
+
+    /* Blend the resolved transparency over the target framebuffer and restore GL state
+     * @param target: framebuffer with the opaque image, 0 = default framebuffer
+     */
+    void composite(GLuint target = 0);
+
+    void clear();
+
+private:
+    ShaderProgram* composite_shader = nullptr;
+    GLuint FBO = 0;
+    GLuint accum_texture = 0;
+    GLuint revealage_texture = 0;
+    GLuint depth_buffer = 0;
+    GLuint empty_VAO = 0; // fullscreen triangle is generated from gl_VertexID
+    int width = 0;
+    int height = 0;
+
+    void create_targets(int width, int height);
+    void delete_targets();
+};
+
+#endif // WEIGHTEDOIT_HPP
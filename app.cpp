@@ -3,9 +3,11 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <opencv2/opencv.hpp>
 #include <random>
 #include <string>
@@ -193,6 +195,80 @@ GLuint App::gen_tex(cv::Mat& image, TextureFilter filter = TextureFilter::Trilin
     return ID;
 }
 
+/* Create GL_TEXTURE_2D_ARRAY, one layer per image
+ * All images must have the same size, they are converted to BGRA.
+ * @param images: layers of the array
+ * @param filter: texture filtering
+ * @return: texture ID
+ */
+GLuint App::gen_tex_array(std::vector<cv::Mat>& images, TextureFilter filter = TextureFilter::TrilinearMipmap) {
+    GLuint ID;
+
+    if (images.empty()) {
+        throw std::runtime_error("No images for texture array.\n");
+    }
+    int width = images[0].cols;
+    int height = images[0].rows;
+
+    GLsizei levels = 1;
+    if (filter == TextureFilter::TrilinearMipmap) {
+        levels = 1 + (GLsizei)std::floor(std::log2(std::max(width, height)));
+    }
+
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &ID);
+    glTextureStorage3D(ID, levels, GL_RGBA8, width, height, (GLsizei)images.size());
+
+    for (size_t layer = 0; layer < images.size(); ++layer) {
+        cv::Mat bgra;
+        switch (images[layer].channels()) {
+            case 1:
+                cv::cvtColor(images[layer], bgra, cv::COLOR_GRAY2BGRA);
+                break;
+            case 3:
+                cv::cvtColor(images[layer], bgra, cv::COLOR_BGR2BGRA);
+                break;
+            case 4:
+                bgra = images[layer];
+                break;
+            default:
+                throw std::runtime_error("texture array failed");
+        }
+        if (bgra.cols != width || bgra.rows != height) {
+            throw std::runtime_error("Texture array layers must have the same size.");
+        }
+        if (!bgra.isContinuous()) {
+            bgra = bgra.clone();
+        }
+        glTextureSubImage3D(ID, 0, 0, 0, (GLint)layer, width, height, 1, GL_BGRA, GL_UNSIGNED_BYTE,
+                            bgra.data);
+    }
+
+    switch (filter) {
+        case TextureFilter::Nearest:
+            glTextureParameteri(ID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTextureParameteri(ID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            break;
+
+        case TextureFilter::Bilinear:
+            glTextureParameteri(ID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(ID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            break;
+
+        case TextureFilter::TrilinearMipmap:
+            glTextureParameteri(ID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);  // bilinear magnifying
+            glTextureParameteri(ID, GL_TEXTURE_MIN_FILTER,
+                                GL_LINEAR_MIPMAP_LINEAR);  // trilinear minifying
+            glGenerateTextureMipmap(ID);                   // Generate mipmaps
+            break;
+    }
+
+    // Configures the way the texture repeats
+    glTextureParameteri(ID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(ID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    return ID;
+}
+
 bool App::webcam_init() {
     //open capture device
     //open first available camera
@@ -267,6 +343,10 @@ bool App::init() {
         if (!GLEW_ARB_direct_state_access) {
             throw std::runtime_error("No DSA :-(");
         }
+        ShaderProgram::init_parallel_compile();
+        stream_buffer.init(1024 * 1024); // per frame, grows if a level needs more
+        frame_uniforms.init(stream_buffer);
+        clustered_lighting.init(stream_buffer);
         init_assets();
 
         // When all is loaded, show the window.
@@ -306,7 +386,11 @@ void App::init_gl_debug() {
     }
 }
 
-GLuint textureInit(const std::filesystem::path& file_name) {
+/* Load image for a texture (flipped for OpenGL), checkerboard if missing
+ * @param file_name: path to the image
+ * @return: image data
+ */
+cv::Mat textureLoad(const std::filesystem::path& file_name) {
     cv::Mat image =
         cv::imread(file_name.string(), cv::IMREAD_UNCHANGED);  // Read with (potential) Alpha
     if (image.empty()) {
@@ -316,12 +400,65 @@ GLuint textureInit(const std::filesystem::path& file_name) {
     }
 
     cv::flip(image, image, 0);
+    return image;
+}
+
+GLuint textureInit(const std::filesystem::path& file_name) {
+    cv::Mat image = textureLoad(file_name);
 
     GLuint texture = App::gen_tex(image, TextureFilter::TrilinearMipmap);
 
     return texture;
 }
 
+/* Pack textures of map models into GL_TEXTURE_2D_ARRAYs.
+ * Tokens with the same "texture_array" name in map_2_models.json share one array,
+ * the layer index is stored in Model::texture_layer. A texture with a different size
+ * than the first one of the group is not packed, the model keeps its own texture only.
+ * @param map_models: "map_2_models" JSON array
+ */
+void App::init_texture_arrays(const nlohmann::json& map_models) {
+    // array name -> (token, image) in layer order
+    std::map<std::string, std::vector<std::pair<std::string, cv::Mat>>> groups;
+
+    for (const auto& model_data : map_models) {
+        if (model_data.find("texture_array") == model_data.end() ||
+            model_data.find("texture_path") == model_data.end()) {
+            continue;
+        }
+        std::string array_name = model_data["texture_array"];
+        std::string token = model_data["token"];
+        std::string texture_path = model_data["texture_path"];
+        cv::Mat image = textureLoad(texture_path);
+
+        auto& group = groups[array_name];
+        if (!group.empty() && (image.cols != group[0].second.cols || image.rows != group[0].second.rows)) {
+            std::cerr << "Texture array '" << array_name << "': " << texture_path << " has size "
+                      << image.cols << "x" << image.rows << ", expected " << group[0].second.cols
+                      << "x" << group[0].second.rows << " - not packed." << std::endl;
+            continue;
+        }
+        group.emplace_back(token, image);
+    }
+
+    for (auto& [array_name, group] : groups) {
+        std::vector<cv::Mat> images;
+        for (auto& [token, image] : group) {
+            images.push_back(image);
+        }
+        GLuint array_id = App::gen_tex_array(images, TextureFilter::TrilinearMipmap);
+
+        for (int layer = 0; layer < (int)group.size(); ++layer) {
+            Model& model = map_2_model_dict[group[layer].first];
+            model.texture_array_id = array_id;
+            model.texture_layer = layer;
+        }
+        std::cout << "Texture array '" << array_name << "' (ID " << array_id << "): "
+                  << group.size() << " layers " << images[0].cols << "x" << images[0].rows
+                  << std::endl;
+    }
+}
+
 /*
  * Initialize the map for the given level and generate the scene.
  * This function reads the level from a file, initializes the map,
@@ -341,6 +478,8 @@ void App::init_map_for_level_and_generate_scene(int level) {
 
 	// clear models
 	models.clear();
+	models_version++;
+	lights.clear();
 
     // place models to the scene
     int light_source_count = 1;
@@ -365,6 +504,7 @@ void App::init_map_for_level_and_generate_scene(int level) {
                 } else {
                     auto model = std::make_unique<Model>(base);
                     model->origin = pos;
+                    model->baked = StaticLevelMesh::is_static(base);
                     models.push_back(std::move(model));
                 }
                 if (base.light_source) {
@@ -384,10 +524,7 @@ void App::init_map_for_level_and_generate_scene(int level) {
     }
 
     std::cout << "Light source added (" << light_source_count << " total)" << std::endl;
-    if (light_source_count > MAX_LIGHTS) {
-        std::cerr << "Warning: More light sources than supported by MAX_LIGHTS (" << MAX_LIGHTS
-                  << "). Some lights may not be rendered." << std::endl;
-    }
+    upload_lights();
 
     // add floor
     Model floor = map_2_model_dict["floor"];
@@ -397,14 +534,76 @@ void App::init_map_for_level_and_generate_scene(int level) {
     floor.origin = glm::vec3(0.5, -1.0, 0.5);
     models.push_back(std::make_unique<Model>(floor));
 
+    // merge visible faces of static walls into one mesh
+    static_level.build(map, map_2_model_dict, offset);
+
+    // trace which lights can reach each tile
+    light_visibility.build(map, map_2_model_dict, models, lights, offset);
+
+    // bake wall lighting on all cores, or load it from the cache
+    lightmap_baker.build(level_file, map, map_2_model_dict, static_level, lights, offset);
+
+    // bucket models to map tiles for frustum culling (tile (i, j) is centered at (i, 0, j) + offset)
+    scene_grid.build(models, models_version, map.getCols(), map.getRows(),
+                     glm::vec2(offset.x, offset.z) - 0.5f);
+
+    // split the map to rooms connected by doors
+    portal_culler.build(map, map_2_model_dict, models, offset);
+
     // set player position in 3D space (transform X-Y in map to XYZ in GL)
     camera.Position.x = (map.start_position.x) + 1.0 / 2.0f;
     camera.Position.z = (map.start_position.y) + 1.0 / 2.0f;
     camera.Position.y = camera.camera_height;
 
+    // first draw of each prototype now, not when it first shows up in the game
+    prewarm_pipeline();
+
     std::cout << "Scene generated." << std::endl;
 }
 
+/* Get shader program from shader cache, compile it if not already present
+ * @param vertex_shader_path: path to vertex shader
+ * @param fragment_shader_path: path to fragment shader
+ * @param defines: permutation of the shaders, each one is a separate program
+ * @return: cached shader program
+ */
+ShaderProgram& App::cached_shader(const std::filesystem::path& vertex_shader_path,
+                                  const std::filesystem::path& fragment_shader_path,
+                                  const std::vector<std::string>& defines) {
+    std::string shader_key = ShaderProgram::cache_key(vertex_shader_path, fragment_shader_path, defines);
+    if (shader_cache.find(shader_key) == shader_cache.end()) {
+        // linked on first use, the driver compiles in the meantime
+        shader_cache[shader_key] = ShaderProgram(vertex_shader_path, fragment_shader_path, defines);
+        std::cout << "Shader program " << shader_key << " queued and cached." << std::endl;
+    }
+    return shader_cache[shader_key];
+}
+
+/* Per frame: recompile shaders whose files changed, swap in those that finished linking.
+ * Programs are replaced in place, so all references to shader_cache stay valid
+ * and the old program is used until the new one is ready.
+ */
+void App::update_shaders() {
+    for (const auto& file : shader_watcher.changes()) {
+        std::cout << "Shader changed: " << file.string() << std::endl;
+        for (auto& [key, program] : shader_cache) {
+            if (program.uses(file)) {
+                program.reload();
+            }
+        }
+    }
+
+    for (auto& [key, program] : shader_cache) {
+        // never wait for the driver here, check again next frame
+        if (program.reload_pending() && program.compile_ready()) {
+            if (program.finish_compile()) {
+                shader_reloads++;
+                std::cout << "Shader program " << key << " reloaded." << std::endl;
+            }
+        }
+    }
+}
+
 /*
  * Initialize pipeline: compile, link and use shaders
  * Create and load data into GPU using OpenGL DSA (Direct State Access)
@@ -462,6 +661,9 @@ void App::init_assets(void) {
 
     std::cout << "Models loaded." << std::endl;
 
+    // wall textures of the same size -> one texture array
+    init_texture_arrays(json["map_2_models"]);
+
     // print loaded collectible objects
     std::cout << "Collectible objects: ";
     for (const auto& obj : map_2_model_dict) {
@@ -507,6 +709,57 @@ void App::init_assets(void) {
 	}
 	std::cout << std::endl;
 
+    // shaders for the instanced render path
+    instanced_lit_shader = &cached_shader("resources/shaders/lighting_instanced.vert",
+                                          "resources/shaders/lighting_instanced.frag");
+    instanced_lit_array_shader = &cached_shader("resources/shaders/lighting_instanced.vert",
+                                                "resources/shaders/lighting_instanced.frag", { "TEXTURE_ARRAY 1" });
+    instanced_unlit_shader = &cached_shader("resources/shaders/tex_instanced.vert",
+                                            "resources/shaders/tex.frag");
+    instanced_renderer.init(*instanced_lit_shader, *instanced_lit_array_shader, *instanced_unlit_shader,
+                            stream_buffer);
+
+    // shared geometry for the multi-draw-indirect render path
+    indirect_shader = &cached_shader("resources/shaders/lighting_indirect.vert",
+                                     "resources/shaders/lighting_instanced.frag", { "TEXTURE_ARRAY 1" });
+    indirect_renderer.init(map_2_model_dict, *indirect_shader, stream_buffer);
+
+    // position-only programs for the depth pre-pass
+    depth_shader = &cached_shader("resources/shaders/depth.vert", "resources/shaders/depth.frag");
+    depth_indirect_shader = &cached_shader("resources/shaders/depth_indirect.vert", "resources/shaders/depth.frag");
+
+    // G-buffer and light resolve for deferred shading
+    gbuffer_shader = &cached_shader("resources/shaders/lighting.vert", "resources/shaders/gbuffer.frag");
+    gbuffer_array_shader = &cached_shader("resources/shaders/lighting_indirect.vert", "resources/shaders/gbuffer.frag",
+                                          { "TEXTURE_ARRAY 1" });
+    deferred_renderer.init(cached_shader("resources/shaders/oit_composite.vert", "resources/shaders/deferred_resolve.frag"));
+
+    // baked static level lit from its lightmap
+    lightmap_shader = &cached_shader("resources/shaders/lightmap.vert", "resources/shaders/lightmap.frag");
+
+    // bounding boxes for occlusion queries
+    occlusion.init(cached_shader("resources/shaders/occlusion_box.vert", "resources/shaders/occlusion_box.frag"));
+
+    // camera facing sprites from the sprite texture array
+    sprite_renderer.init(cached_shader("resources/shaders/sprite_billboard.vert", "resources/shaders/sprite_array.frag"),
+                         cached_shader("resources/shaders/sprite_billboard.vert", "resources/shaders/sprite_array_oit.frag"),
+                         cached_shader("resources/shaders/sprite_billboard.vert", "resources/shaders/sprite_array.frag", { "ALPHA_TEST 1" }),
+                         model_cache["sprite"].meshes[0].get_buffers(), stream_buffer);
+
+    // weighted blended order-independent transparency
+    oit_shader = &cached_shader("resources/shaders/tex.vert", "resources/shaders/tex_oit.frag");
+    // OIT needs no order, so transparent models of one token are one instanced draw
+    ShaderProgram& oit_instanced_shader =
+        cached_shader("resources/shaders/tex_instanced.vert", "resources/shaders/tex_oit.frag");
+    oit_instanced_renderer.init(oit_instanced_shader, oit_instanced_shader, oit_instanced_shader, stream_buffer,
+                                false);
+    weighted_oit.init(cached_shader("resources/shaders/oit_composite.vert", "resources/shaders/oit_composite.frag"));
+
+    // link everything compiled so far before the level build, its time is not compile time
+    for (auto& [key, program] : shader_cache) {
+        program.wait();
+    }
+
     // load level
 	init_map_for_level_and_generate_scene(level);
 
@@ -515,6 +768,22 @@ void App::init_assets(void) {
     status_bar->loadAssets();
 
     std::cout << "Status bar loaded." << std::endl;
+
+    std::cout << "Shader binary cache: " << ShaderProgram::binary_cache_hits << " loaded, "
+              << ShaderProgram::binary_cache_misses << " compiled in " << ShaderProgram::compile_ms_total
+              << " ms, " << ShaderProgram::binary_cache_saved_ms << " ms saved." << std::endl;
+
+    // hot reload of every shader file in use
+    std::vector<std::filesystem::path> shader_files;
+    for (const auto& [key, program] : shader_cache) {
+        for (const auto& file : { program.get_vertex_file(), program.get_fragment_file() }) {
+            if (std::find(shader_files.begin(), shader_files.end(), file) == shader_files.end()) {
+                shader_files.push_back(file);
+            }
+        }
+    }
+    shader_watcher.start(shader_files);
+    std::cout << "Watching " << shader_files.size() << " shader files." << std::endl;
 }
 
 void App::print_opencv_info() {
@@ -666,13 +935,12 @@ void App::thread_code(void) {
 
     double last_frame_time = glfwGetTime();
 
-    glm::vec3 offset = glm::vec3(0.0);
-    glm::vec3 rotation = glm::vec3(0.0f);
-    glm::vec3 scale_change = glm::vec3(1.0f);
-
     char movement_local = 'n';
 
     while (!glfwWindowShouldClose(window)) {
+        // next region of the per-frame ring, written while the GPU reads the previous frames
+        stream_buffer.begin_frame();
+
         // new level?
         if (load_new_level) {
             load_new_level = false; // reset flag
@@ -695,7 +963,7 @@ void App::thread_code(void) {
             ImGui_ImplGlfw_NewFrame();
             ImGui::NewFrame();
             ImGui::SetNextWindowPos(ImVec2(10, 10));
-            ImGui::SetNextWindowSize(ImVec2(350, 190));
+            ImGui::SetNextWindowSize(ImVec2(450, 570));
             ImGui::Begin("Info", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
             ImGui::Text("Camera position: (%.2f, %.2f, %.2f)", camera.Position.x,
                         camera.Position.z, camera.Position.y);
@@ -703,6 +971,43 @@ void App::thread_code(void) {
                         camera.Roll);
             ImGui::Text("V-Sync: %s", is_vsync_on ? "ON" : "OFF");
             ImGui::Text("FPS: %.1f", FPS);
+            ImGui::Text("Instanced rendering: %s (I)", instanced_rendering ? "ON" : "OFF");
+            ImGui::Text("Baked static level: %s (B)", static_level_enabled ? "ON" : "OFF");
+            ImGui::Text("Multi-draw indirect: %s (M), %d commands", indirect_rendering ? "ON" : "OFF",
+                        indirect_renderer.commands);
+            ImGui::Text("Clustered lighting: %s (L), %d lights, max %d per cluster",
+                        clustered_lighting_enabled ? "ON" : "OFF", light_buffer.size(),
+                        clustered_lighting.max_lights_per_cluster);
+            ImGui::Text("Light visibility: %s (P), %d re-bakes", light_visibility_enabled ? "ON" : "OFF",
+                        light_visibility.rebakes);
+            ImGui::Text("Render queue: %d items, elided binds: shader %d, texture %d, VAO %d",
+                        render_queue.stats.items, render_queue.stats.shader_binds_elided,
+                        render_queue.stats.texture_binds_elided, render_queue.stats.vao_binds_elided);
+            ImGui::Text("Frustum culling: %s (K), visible %d / %d", frustum_culling ? "ON" : "OFF",
+                        frustum_culling ? scene_grid.visible : (int)models.size(), (int)models.size());
+            ImGui::Text("Portal culling: %s (G), rooms %d / %d", portal_culling ? "ON" : "OFF",
+                        portal_culling ? portal_culler.rooms_reached : portal_culler.room_count,
+                        portal_culler.room_count);
+            ImGui::Text("Occlusion queries: %s (O), %d tested, %d hidden, %d issued",
+                        occlusion_queries ? "ON" : "OFF", occlusion.tested, occlusion.hidden, occlusion.issued);
+            ImGui::Text("Sprite billboarding: %s (T), %d sprites in %d draws", sprite_billboarding ? "ON" : "OFF",
+                        sprite_renderer.instances, sprite_renderer.draw_calls);
+            ImGui::Text("Order-independent transparency: %s (Y)", oit_enabled ? "ON" : "OFF");
+            ImGui::Text("Cutout: %d models, alpha-to-coverage: %s (U)", (int)cutout_models.size(),
+                        alpha_to_coverage ? "ON" : "OFF");
+            ImGui::Text("Depth pre-pass: %s (Z)", z_prepass ? "ON" : "OFF");
+            ImGui::Text("Deferred shading: %s (N)", deferred_shading ? "ON" : "OFF");
+            ImGui::Text("Lightmaps: %s (H), %dx%d atlas %s in %.0f ms", lightmaps_enabled ? "ON" : "OFF",
+                        lightmap_baker.width, lightmap_baker.height,
+                        lightmap_baker.from_cache ? "loaded" : "baked", lightmap_baker.bake_ms);
+            ImGui::Text("Shader hot reload: %d reloads, binary cache %d hits", shader_reloads,
+                        ShaderProgram::binary_cache_hits);
+            ImGui::Text("Pipeline pre-warm: %d entries in %.1f ms",
+                        (int)pipeline_prewarm.get_entries().size(), pipeline_prewarm.get_total_ms());
+            ImGui::Text("Stream ring: %d / %d KiB per frame, %d stalls, %d grows",
+                        (int)(stream_buffer.used / 1024), (int)(stream_buffer.get_frame_size() / 1024),
+                        stream_buffer.stalls, stream_buffer.grows);
+            ImGui::Text("Draw calls: %d", render_stats.draw_calls);
             ImGui::Text("Player Health: %d, Gold: %d, Ammo: %d", player.health, player.gold,
                         player.ammo);
             ImGui::Text("(press UP/DOWN to change color)");
@@ -775,6 +1080,7 @@ void App::thread_code(void) {
                                     << std::endl;
                     }
                     it = models.erase(it);
+                    models_version++;
                     continue;
                 }
             }
@@ -800,6 +1106,7 @@ void App::thread_code(void) {
                             models.push_back(std::make_unique<Model>(corpse));
                             std::cout << "Enemy killed: " << (*it)->name << std::endl;
                             it = models.erase(it);
+                            models_version++;
                             continue;
                         }
                     }
@@ -829,117 +1136,19 @@ void App::thread_code(void) {
 
         // Get matrices once per frame
         glm::mat4 viewMatrix = camera.GetViewMatrix();
+        update_shaders();
+        frame_uniforms.update(viewMatrix, projection_matrix, camera.Position, (float)glfwGetTime());
+        clustered_lighting.update(clustered_lighting_enabled, lights, viewMatrix, projection_matrix, width, height);
+        light_visibility.update(light_visibility_enabled);
+        render_stats = RenderStats();
         // Prepare for transparency
-        std::vector<Model*> transparent;
-        transparent.reserve(models.size());
+        transparent_models.clear();
 
         // --- OPAQUE OBJECTS RENDER PASS ---
-        for (auto& model : models) {
-            model->update(delta_t);
-            if (!model->transparent) {
-                // Get the specific shader for THIS model
-                ShaderProgram& shader = model->meshes[0].shader;
-                shader.activate();
-
-                // Set matrices required by ALL shaders
-                shader.setUniform("v_m", viewMatrix);
-                shader.setUniform("p_m", projection_matrix);
-
-                // If it's the lighting shader, set the lighting uniforms
-                if (shader.hasUniform("light_position")) {
-                    // Set the light position in view space
-                    const Light& light = lights[0];
-                    glm::vec3 lightPositionView = glm::vec3(viewMatrix * glm::vec4(light.position, 1.0f));
-                    shader.setUniform("light_position", lightPositionView);
-                    // Set the light properties
-                    shader.setUniform("ambient_intensity", light.ambient);
-                    shader.setUniform("diffuse_intensity", light.diffuse);
-                    shader.setUniform("specular_intensity", light.specular);
-                } else {
-                    for (size_t i = 0; i < lights.size() && i < MAX_LIGHTS; ++i) {
-                        const Light& light = lights[i];
-                        bool visible = true;
-                        /*
-                        // raycasting to check if the light is visible
-                        if (i > 1) {
-                            glm::vec3 from = model->origin;
-                            glm::vec3 to = light.position;
-                            glm::vec3 dir = glm::normalize(to - from);
-                            float distance = glm::distance(from, to);
-                            float step = 0.2f; // krok v mapě
-                            for (float d = step; d < distance; d += step) {
-                                glm::vec3 pos = from + dir * d;
-                                int x = int(pos.x);
-                                int z = int(pos.z);
-                                if (map.containsWall(x, z)) {
-                                    visible = false;
-                                    break;
-                                }
-                            }
-                        }
-                        */
-                        shader.setUniform("lights[" + std::to_string(i) + "].isActive", visible);
-                        shader.setUniform("lights[" + std::to_string(i) + "].position",
-                                            light.position);
-                        shader.setUniform("lights[" + std::to_string(i) + "].ambient_intensity",
-                                            light.ambient);
-                        shader.setUniform("lights[" + std::to_string(i) + "].diffuse_intensity",
-                                            light.diffuse);
-                        shader.setUniform("lights[" + std::to_string(i) + "].specular_intensity",
-                                            light.specular);
-                    }
-                }
-
-                rotation = glm::vec3(0.0f);
-                if (model->isSprite) {
-                    glm::vec3 sprite_position = model->origin;
-                    glm::vec3 camera_position = camera.Position;
-                    glm::vec3 direction = glm::normalize(camera_position - sprite_position);
-                    float angle = atan2(direction.x, direction.z);
-                    rotation = glm::vec3(0.0f, angle, 0.0f);
-                }
-                model->draw(offset, rotation, scale_change);
-            } else {
-                transparent.emplace_back(model.get());
-            }
-        }
-
-        // Sort transparent objects
-        std::sort(transparent.begin(), transparent.end(), [&](Model const* a, Model const* b) {
-            return glm::distance(camera.Position, a->origin) >
-                    glm::distance(camera.Position, b->origin);
-        });
-
-        // Set GL state for transparency
-        glEnable(GL_BLEND);
-        glDepthMask(GL_FALSE);
-        glDisable(GL_CULL_FACE);
+        render_opaque(viewMatrix, delta_t, transparent_models);
 
         // --- TRANSPARENT OBJECTS RENDER PASS ---
-        for (auto model : transparent) {
-            // Get the specific shader for THIS model
-            ShaderProgram& shader = model->meshes[0].shader;
-            shader.activate();
-
-            // Set matrices required by ALL shaders
-            shader.setUniform("v_m", viewMatrix);
-            shader.setUniform("p_m", projection_matrix);
-
-            rotation = glm::vec3(0.0f);
-            if (model->isSprite) {
-                glm::vec3 sprite_position = model->origin;
-                glm::vec3 camera_position = camera.Position;
-                glm::vec3 direction = glm::normalize(camera_position - sprite_position);
-                float angle = atan2(direction.x, direction.z);
-                rotation = glm::vec3(0.0f, angle, 0.0f);
-            }
-            model->draw(offset, rotation, scale_change);
-        }
-
-        // Restore GL state
-        glDisable(GL_BLEND);
-        glDepthMask(GL_TRUE);
-        glEnable(GL_CULL_FACE);
+        render_transparent(transparent_models);
 
         // --- UI & FINAL PRESENTATION ---
         status_bar->update(player);
@@ -950,6 +1159,7 @@ void App::thread_code(void) {
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         }
 
+        stream_buffer.end_frame();
         glfwSwapBuffers(window);
         glfwPollEvents();
 
@@ -1120,7 +1330,29 @@ void App::destroy(void) {
 }
 
 App::~App() {
+    shader_watcher.stop();
     models.clear();  // Clear the vector to release the memory
+    instanced_renderer.clear();
+    oit_instanced_renderer.clear();
+    indirect_renderer.clear();
+    light_buffer.clear();
+    clustered_lighting.clear();
+    light_visibility.clear();
+    scene_grid.clear();
+    portal_culler.clear();
+    occlusion.clear();
+    sprite_renderer.clear();
+    weighted_oit.clear();
+    deferred_renderer.clear();
+    lightmap_baker.clear();
+    pipeline_prewarm.clear();
+    frame_uniforms.clear();
+    stream_buffer.clear();
+    static_level.clear();
+    // release shared GPU meshes while the GL context still exists
+    map_2_model_dict.clear();
+    model_cache.clear();
+    status_bar.reset();
 
     destroy();
     std::cout << "Bye...\n";
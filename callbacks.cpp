@@ -31,6 +31,76 @@ void App::glfw_key_callback(GLFWwindow* window, int key, int scancode, int actio
 			case GLFW_KEY_F:
 				this_inst->camera.freeCam = !this_inst->camera.freeCam;
 				break;
+			case GLFW_KEY_I:
+				// instanced rendering on/off
+				this_inst->instanced_rendering = !this_inst->instanced_rendering;
+				std::cout << "Instanced rendering: " << this_inst->instanced_rendering << "\n";
+				break;
+			case GLFW_KEY_B:
+				// baked static level geometry on/off
+				this_inst->static_level_enabled = !this_inst->static_level_enabled;
+				std::cout << "Baked static level: " << this_inst->static_level_enabled << "\n";
+				break;
+			case GLFW_KEY_M:
+				// multi-draw indirect rendering on/off
+				this_inst->indirect_rendering = !this_inst->indirect_rendering;
+				std::cout << "Multi-draw indirect: " << this_inst->indirect_rendering << "\n";
+				break;
+			case GLFW_KEY_L:
+				// clustered forward lighting on/off
+				this_inst->clustered_lighting_enabled = !this_inst->clustered_lighting_enabled;
+				std::cout << "Clustered lighting: " << this_inst->clustered_lighting_enabled << "\n";
+				break;
+			case GLFW_KEY_P:
+				// precomputed light visibility on/off
+				this_inst->light_visibility_enabled = !this_inst->light_visibility_enabled;
+				std::cout << "Light visibility: " << this_inst->light_visibility_enabled << "\n";
+				break;
+			case GLFW_KEY_K:
+				// frustum culling on/off
+				this_inst->frustum_culling = !this_inst->frustum_culling;
+				std::cout << "Frustum culling: " << this_inst->frustum_culling << "\n";
+				break;
+			case GLFW_KEY_G:
+				// door-aware portal culling on/off
+				this_inst->portal_culling = !this_inst->portal_culling;
+				std::cout << "Portal culling: " << this_inst->portal_culling << "\n";
+				break;
+			case GLFW_KEY_O:
+				// occlusion queries for sprites on/off
+				this_inst->occlusion_queries = !this_inst->occlusion_queries;
+				std::cout << "Occlusion queries: " << this_inst->occlusion_queries << "\n";
+				break;
+			case GLFW_KEY_T:
+				// vertex shader billboarding of sprites on/off
+				this_inst->sprite_billboarding = !this_inst->sprite_billboarding;
+				std::cout << "Sprite billboarding: " << this_inst->sprite_billboarding << "\n";
+				break;
+			case GLFW_KEY_Y:
+				// weighted blended OIT on/off
+				this_inst->oit_enabled = !this_inst->oit_enabled;
+				std::cout << "Order-independent transparency: " << this_inst->oit_enabled << "\n";
+				break;
+			case GLFW_KEY_U:
+				// alpha-to-coverage for cutout sprites on/off
+				this_inst->alpha_to_coverage = !this_inst->alpha_to_coverage;
+				std::cout << "Alpha-to-coverage: " << this_inst->alpha_to_coverage << "\n";
+				break;
+			case GLFW_KEY_Z:
+				// depth pre-pass on/off
+				this_inst->z_prepass = !this_inst->z_prepass;
+				std::cout << "Depth pre-pass: " << this_inst->z_prepass << "\n";
+				break;
+			case GLFW_KEY_N:
+				// deferred shading on/off
+				this_inst->deferred_shading = !this_inst->deferred_shading;
+				std::cout << "Deferred shading: " << this_inst->deferred_shading << "\n";
+				break;
+			case GLFW_KEY_H:
+				// baked lightmaps for static walls on/off
+				this_inst->lightmaps_enabled = !this_inst->lightmaps_enabled;
+				std::cout << "Lightmaps: " << this_inst->lightmaps_enabled << "\n";
+				break;
 			case GLFW_KEY_R:
 				// interact with objects (open doors, etc.)
 				for (auto& model : this_inst->models) {
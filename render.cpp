@@ -0,0 +1,461 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "App.hpp"
+
+/* Set light uniforms of a lighting shader
+ * Only the single directional light uses uniforms, point lights live in light_buffer.
+ * @param shader: active shader program
+ * @param view_matrix: current view matrix
+ */
+void App::set_light_uniforms(ShaderProgram& shader, const glm::mat4& view_matrix) {
+    static constexpr UniformName LIGHT_POSITION{ "light_position" };
+    static constexpr UniformName AMBIENT_INTENSITY{ "ambient_intensity" };
+    static constexpr UniformName DIFFUSE_INTENSITY{ "diffuse_intensity" };
+    static constexpr UniformName SPECULAR_INTENSITY{ "specular_intensity" };
+
+    // If it's the directional shader, set the lighting uniforms
+    if (Uniform<glm::vec3> light_position = shader.uniform<glm::vec3>(LIGHT_POSITION)) {
+        // Set the light position in view space
+        const Light& light = lights[0];
+        light_position.set(glm::vec3(view_matrix * glm::vec4(light.position, 1.0f)));
+        // Set the light properties
+        shader.uniform<glm::vec3>(AMBIENT_INTENSITY).set(light.ambient);
+        shader.uniform<glm::vec3>(DIFFUSE_INTENSITY).set(light.diffuse);
+        shader.uniform<glm::vec3>(SPECULAR_INTENSITY).set(light.specular);
+    }
+    // point lights are read from light_buffer (see upload_lights)
+}
+
+/* Upload all lights of the level into light_buffer.
+ * Call whenever the lights change.
+ */
+void App::upload_lights() {
+    light_buffer.upload(lights);
+    std::cout << "Lights uploaded: " << light_buffer.size() << std::endl;
+}
+
+/* Rotation turning a sprite towards the camera (around Y axis)
+ * @param model: drawn model
+ * @return: rotation for Model::draw, zero for non-sprites
+ */
+glm::vec3 App::sprite_rotation(const Model& model) {
+    if (!model.isSprite) {
+        return glm::vec3(0.0f);
+    }
+    glm::vec3 sprite_position = model.origin;
+    glm::vec3 camera_position = camera.Position;
+    glm::vec3 direction = glm::normalize(camera_position - sprite_position);
+    float angle = atan2(direction.x, direction.z);
+    return glm::vec3(0.0f, angle, 0.0f);
+}
+
+/* Update all models and draw the opaque ones.
+ * Transparent models are only collected for the later sorted pass.
+ * @param view_matrix: current view matrix
+ * @param delta_t: time since last frame
+ * @param transparent: output list of transparent models
+ */
+void App::render_opaque(const glm::mat4& view_matrix, float delta_t, std::vector<Model*>& transparent) {
+    glm::vec3 offset = glm::vec3(0.0);
+    glm::vec3 scale_change = glm::vec3(1.0f);
+
+    render_queue.clear();
+
+    if (indirect_rendering) {
+        // commands are rebuilt only if models were added or removed since the last frame
+        indirect_renderer.sync(models, models_version, static_level_enabled);
+    }
+
+    for (auto& model : models) {
+        model->update(delta_t);
+    }
+
+    // models in the view frustum
+    Frustum frustum(projection_matrix * view_matrix);
+    std::vector<Model*> visible;
+    visible.reserve(models.size());
+    if (frustum_culling) {
+        if (!scene_grid.is_built(models_version)) {
+            // models were added or removed
+            scene_grid.rebuild(models, models_version);
+        }
+        scene_grid.cull(frustum, visible);
+    } else {
+        for (auto& model : models) {
+            visible.push_back(model.get());
+        }
+    }
+
+    if (portal_culling) {
+        // drop models of rooms hidden behind closed doors or out of view
+        portal_culler.update(camera.Position, frustum);
+        visible.erase(std::remove_if(visible.begin(), visible.end(),
+                                     [&](const Model* model) { return !portal_culler.is_visible(*model); }),
+                      visible.end());
+    }
+
+    cutout_models.clear();
+    for (Model* model : visible) {
+        if (model->transparent) {
+            transparent.emplace_back(model);
+            continue;
+        }
+
+        if (model->cutout) {
+            // drawn after the walls, see render_cutout
+            cutout_models.push_back(model);
+            continue;
+        }
+
+        if (model->baked && static_level_enabled) {
+            // part of static_level
+            continue;
+        }
+
+        if (indirect_rendering && IndirectRenderer::accepts(*model, static_level_enabled)) {
+            // part of the indirect command buffer
+            continue;
+        }
+
+        glm::vec3 rotation = sprite_rotation(*model);
+        if (instanced_rendering && !model->token.empty()) {
+            // drawn later, together with all models of the same token
+            instanced_renderer.submit(*model, model->compute_model_matrix(offset, rotation, scale_change));
+            continue;
+        }
+
+        // drawn below, sorted by shader, texture and mesh
+        render_queue.push(RenderQueue::Pass::Opaque, *model,
+                          model->local_model_matrix * model->compute_model_matrix(offset, rotation, scale_change),
+                          glm::distance(camera.Position, model->origin));
+    }
+
+    if (deferred_shading) {
+        // G-buffer from the same meshes, then one lighting pass over the screen
+        deferred_renderer.begin(width, height);
+
+        render_stats.draw_calls += render_queue.submit(RenderQueue::Pass::Opaque, nullptr, gbuffer_shader);
+        if (static_level_enabled) {
+            render_stats.draw_calls += static_level.draw(gbuffer_shader);
+        }
+        if (indirect_rendering) {
+            indirect_renderer.draw(gbuffer_array_shader);
+            render_stats.draw_calls += indirect_renderer.draw_calls;
+        }
+
+        deferred_renderer.resolve(view_matrix, projection_matrix);
+        render_stats.draw_calls++;
+    }
+    else if (z_prepass) {
+        // depth of the lit geometry first, so every visible pixel is lit exactly once
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        render_stats.draw_calls += render_queue.submit_depth(RenderQueue::Pass::Opaque, *depth_shader);
+        if (static_level_enabled) {
+            render_stats.draw_calls += static_level.draw_depth(*depth_shader);
+        }
+        if (indirect_rendering) {
+            indirect_renderer.draw_depth(*depth_indirect_shader);
+            render_stats.draw_calls++;
+        }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    if (!deferred_shading) {
+        render_stats.draw_calls += render_queue.submit(RenderQueue::Pass::Opaque, [&](ShaderProgram& shader) {
+            set_light_uniforms(shader, view_matrix);
+        });
+    }
+
+    if (!deferred_shading && static_level_enabled && !static_level.empty()) {
+        if (lightmaps_enabled && lightmap_baker.ready()) {
+            // one texture fetch instead of the light loop
+            render_stats.draw_calls += static_level.draw_lightmapped(*lightmap_shader, lightmap_baker.get_texture());
+        } else {
+            ShaderProgram& shader = *static_level.get_shader();
+            shader.activate();
+            set_light_uniforms(shader, view_matrix);
+
+            render_stats.draw_calls += static_level.draw();
+        }
+    }
+
+    if (!deferred_shading && indirect_rendering) {
+        ShaderProgram& shader = *indirect_renderer.get_shader();
+        shader.activate();
+        set_light_uniforms(shader, view_matrix);
+
+        indirect_renderer.draw();
+        render_stats.draw_calls += indirect_renderer.draw_calls;
+    }
+
+    if (z_prepass && !deferred_shading) {
+        // instanced batches and cutouts are not in the pre-pass
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_TRUE);
+    }
+
+    // instanced batches are forward shaded, also on top of the deferred image
+    if (instanced_rendering) {
+        for (ShaderProgram* shader : { instanced_lit_shader, instanced_lit_array_shader }) {
+            shader->activate();
+            set_light_uniforms(*shader, view_matrix);
+        }
+
+        instanced_renderer.flush();
+        render_stats.draw_calls += instanced_renderer.draw_calls;
+    }
+
+    if (occlusion_queries) {
+        // bounding boxes of sprites against the depth of the opaque walls
+        occlusion.begin(models_version);
+        occlusion.test(cutout_models, camera.Position);
+        occlusion.test(transparent, camera.Position);
+    }
+
+    render_cutout(cutout_models);
+}
+
+/* Draw alpha tested models with depth writes on, in any order
+ * @param cutout: cutout models collected by render_opaque
+ */
+void App::render_cutout(std::vector<Model*>& cutout) {
+    glm::vec3 offset = glm::vec3(0.0);
+    glm::vec3 scale_change = glm::vec3(1.0f);
+
+    for (Model* model : cutout) {
+        GLuint query = occlusion_queries ? occlusion.query(*model) : 0;
+        if (sprite_billboarding && query == 0 && SpriteRenderer::accepts(*model)) {
+            // one vec4 per sprite, turned to the camera in the vertex shader
+            sprite_renderer.submit(*model);
+            continue;
+        }
+        render_queue.push(RenderQueue::Pass::Cutout, *model,
+                          model->local_model_matrix *
+                              model->compute_model_matrix(offset, sprite_rotation(*model), scale_change),
+                          glm::distance(camera.Position, model->origin), query);
+    }
+
+    // sprites are single sided quads
+    glDisable(GL_CULL_FACE);
+    if (alpha_to_coverage) {
+        // smooth cutout edges, works only with a multisampled framebuffer
+        glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    }
+
+    render_stats.draw_calls += render_queue.submit(RenderQueue::Pass::Cutout);
+    sprite_renderer.flush(camera.Position, SpriteRenderer::Mode::Cutout);
+    render_stats.draw_calls += sprite_renderer.draw_calls;
+
+    glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    glEnable(GL_CULL_FACE);
+}
+
+/* Draw transparent models back to front, or in any order into the weighted blended OIT targets
+ * @param transparent: transparent models collected by render_opaque
+ */
+void App::render_transparent(std::vector<Model*>& transparent) {
+    glm::vec3 offset = glm::vec3(0.0);
+    glm::vec3 scale_change = glm::vec3(1.0f);
+
+    // the queue sorts transparent objects back to front, OIT needs no order at all
+    bool queued = false;
+    for (auto model : transparent) {
+        GLuint query = occlusion_queries ? occlusion.query(*model) : 0;
+        if (sprite_billboarding && query == 0 && SpriteRenderer::accepts(*model)) {
+            // one vec4 per sprite, turned to the camera in the vertex shader
+            sprite_renderer.submit(*model);
+            continue;
+        }
+        if (oit_enabled && query == 0 && !model->token.empty()) {
+            // batched by token like the opaque instancing path, never sorted
+            oit_instanced_renderer.submit(*model, model->compute_model_matrix(offset, sprite_rotation(*model),
+                                                                              scale_change));
+            continue;
+        }
+        queued = true;
+        render_queue.push(RenderQueue::Pass::Transparent, *model,
+                          model->local_model_matrix *
+                              model->compute_model_matrix(offset, sprite_rotation(*model), scale_change),
+                          oit_enabled ? 0.0f : glm::distance(camera.Position, model->origin), query);
+    }
+
+    if (oit_enabled) {
+        weighted_oit.begin(width, height);
+
+        if (queued) {
+            // only models without a token or with an occlusion query are left here
+            render_stats.draw_calls += render_queue.submit(RenderQueue::Pass::Transparent, nullptr, oit_shader);
+        }
+        oit_instanced_renderer.flush();
+        render_stats.draw_calls += oit_instanced_renderer.draw_calls;
+        sprite_renderer.flush(camera.Position, SpriteRenderer::Mode::OIT);
+        render_stats.draw_calls += sprite_renderer.draw_calls;
+
+        weighted_oit.composite();
+        render_stats.draw_calls++;
+        return;
+    }
+
+    // Set GL state for transparency
+    glEnable(GL_BLEND);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+
+    render_stats.draw_calls += render_queue.submit(RenderQueue::Pass::Transparent);
+
+    sprite_renderer.flush(camera.Position);
+    render_stats.draw_calls += sprite_renderer.draw_calls;
+
+    // Restore GL state
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_CULL_FACE);
+}
+
+/* Draw every prototype once through the renderers it would use with the current settings,
+ * so first use of their program/texture/VAO combinations does not hitch in the game.
+ * Called at the end of the level load, models, lights and the camera are already set.
+ */
+void App::prewarm_pipeline() {
+    glm::mat4 view_matrix = camera.GetViewMatrix();
+
+    // stable order of the report
+    std::vector<std::string> tokens;
+    tokens.reserve(map_2_model_dict.size());
+    for (const auto& [token, prototype] : map_2_model_dict) {
+        tokens.push_back(token);
+    }
+    std::sort(tokens.begin(), tokens.end());
+
+    pipeline_prewarm.begin();
+    for (const std::string& token : tokens) {
+        pipeline_prewarm.measure(token, [&]() { return prewarm_model(map_2_model_dict[token], view_matrix); });
+    }
+
+    // merged paths drawn for the whole level, not per prototype
+    if (static_level_enabled && !static_level.empty()) {
+        pipeline_prewarm.measure("static level", [&]() {
+            if (deferred_shading) {
+                deferred_renderer.begin(width, height);
+                int draw_calls = static_level.draw(gbuffer_shader);
+                deferred_renderer.resolve(view_matrix, projection_matrix, pipeline_prewarm.get_framebuffer());
+                return draw_calls + 1;
+            }
+            if (lightmaps_enabled && lightmap_baker.ready()) {
+                return static_level.draw_lightmapped(*lightmap_shader, lightmap_baker.get_texture());
+            }
+            int draw_calls = z_prepass ? static_level.draw_depth(*depth_shader) : 0;
+            return draw_calls + static_level.draw();
+        });
+    }
+    if (indirect_rendering) {
+        pipeline_prewarm.measure("indirect", [&]() {
+            indirect_renderer.sync(models, models_version, static_level_enabled);
+            if (deferred_shading) {
+                deferred_renderer.begin(width, height);
+                indirect_renderer.draw(gbuffer_array_shader);
+                deferred_renderer.resolve(view_matrix, projection_matrix, pipeline_prewarm.get_framebuffer());
+                return indirect_renderer.draw_calls + 1;
+            }
+            int draw_calls = 0;
+            if (z_prepass) {
+                indirect_renderer.draw_depth(*depth_indirect_shader);
+                draw_calls++;
+            }
+            indirect_renderer.draw();
+            return draw_calls + indirect_renderer.draw_calls;
+        });
+    }
+    pipeline_prewarm.end();
+}
+
+/* Draw one prototype the way render_opaque, render_cutout or render_transparent would
+ * @param prototype: model from map_2_model_dict
+ * @param view_matrix: current view matrix (deferred resolve)
+ * @return: number of draw calls, 0 if it is drawn only as part of a merged path
+ */
+int App::prewarm_model(Model& prototype, const glm::mat4& view_matrix) {
+    glm::mat4 model_matrix = prototype.compute_model_matrix();
+    glm::mat4 full_matrix = prototype.local_model_matrix * model_matrix;
+    bool sprite = sprite_billboarding && SpriteRenderer::accepts(prototype);
+    int draw_calls = 0;
+    render_queue.clear();
+
+    if (prototype.transparent) {
+        if (sprite) {
+            sprite_renderer.submit(prototype);
+        } else if (oit_enabled && !prototype.token.empty()) {
+            oit_instanced_renderer.submit(prototype, model_matrix);
+        } else {
+            render_queue.push(RenderQueue::Pass::Transparent, prototype, full_matrix, 0.0f);
+        }
+
+        if (oit_enabled) {
+            weighted_oit.begin(width, height, pipeline_prewarm.get_framebuffer());
+            draw_calls += render_queue.submit(RenderQueue::Pass::Transparent, nullptr, oit_shader);
+            oit_instanced_renderer.flush();
+            sprite_renderer.flush(camera.Position, SpriteRenderer::Mode::OIT);
+            draw_calls += oit_instanced_renderer.draw_calls + sprite_renderer.draw_calls;
+            weighted_oit.composite(pipeline_prewarm.get_framebuffer());
+            draw_calls++;
+        } else {
+            glEnable(GL_BLEND);
+            glDepthMask(GL_FALSE);
+            glDisable(GL_CULL_FACE);
+            draw_calls += render_queue.submit(RenderQueue::Pass::Transparent);
+            sprite_renderer.flush(camera.Position);
+            draw_calls += sprite_renderer.draw_calls;
+            glDisable(GL_BLEND);
+            glDepthMask(GL_TRUE);
+            glEnable(GL_CULL_FACE);
+        }
+    } else if (prototype.cutout) {
+        if (sprite) {
+            sprite_renderer.submit(prototype);
+        } else {
+            render_queue.push(RenderQueue::Pass::Cutout, prototype, full_matrix, 0.0f);
+        }
+
+        glDisable(GL_CULL_FACE);
+        if (alpha_to_coverage) {
+            glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+        }
+        draw_calls += render_queue.submit(RenderQueue::Pass::Cutout);
+        sprite_renderer.flush(camera.Position, SpriteRenderer::Mode::Cutout);
+        draw_calls += sprite_renderer.draw_calls;
+        glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+        glEnable(GL_CULL_FACE);
+    } else if (indirect_rendering && IndirectRenderer::accepts(prototype, static_level_enabled)) {
+        // see the "indirect" entry
+    } else if (instanced_rendering && !prototype.token.empty()) {
+        // instanced batches are forward shaded in every mode
+        instanced_renderer.submit(prototype, model_matrix);
+        instanced_renderer.flush();
+        draw_calls += instanced_renderer.draw_calls;
+    } else {
+        render_queue.push(RenderQueue::Pass::Opaque, prototype, full_matrix, 0.0f);
+        if (deferred_shading) {
+            deferred_renderer.begin(width, height);
+            draw_calls += render_queue.submit(RenderQueue::Pass::Opaque, nullptr, gbuffer_shader);
+            deferred_renderer.resolve(view_matrix, projection_matrix, pipeline_prewarm.get_framebuffer());
+            draw_calls++;
+        } else {
+            if (z_prepass) {
+                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                draw_calls += render_queue.submit_depth(RenderQueue::Pass::Opaque, *depth_shader);
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            }
+            draw_calls += render_queue.submit(RenderQueue::Pass::Opaque);
+        }
+    }
+
+    render_queue.clear();
+    return draw_calls;
+}
@@ -0,0 +1,25 @@
+#version 460 core
+
+// Position-only stream (MeshBuffers::depth_VAO)
+layout (location = 0) in vec4 aPosition;
+
+// Matrices
+uniform mat4 m_m;
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
+
+// depth has to match lighting.vert exactly, the shading pass tests GL_EQUAL
+invariant gl_Position;
+
+void main(void) {
+    // same operations as lighting.vert
+    mat4 mv_m = v_m * m_m;
+    vec4 P = mv_m * aPosition;
+    gl_Position = p_m * P;
+}
@@ -0,0 +1,35 @@
+#version 460 core
+
+// Position-only stream (IndirectRenderer depth VAO)
+layout (location = 0) in vec4 aPosition;
+
+// Per-draw data (see DrawData in IndirectRenderer.hpp), indexed by gl_BaseInstance
+struct DrawData {
+    mat4 model_matrix;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular; // a = shininess
+    ivec4 layer;   // x = texture array layer
+};
+
+layout (std430, binding = 0) readonly buffer DrawDataBuffer {
+    DrawData draws[];
+};
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
+
+// depth has to match lighting_indirect.vert exactly, the shading pass tests GL_EQUAL
+invariant gl_Position;
+
+void main(void) {
+    // same operations as lighting_indirect.vert
+    mat4 mv_m = v_m * draws[gl_BaseInstance].model_matrix;
+    vec4 P = mv_m * aPosition;
+    gl_Position = p_m * P;
+}
@@ -5,8 +5,16 @@ layout (location = 0) in vec4 aPosition;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
-// Matrices 
-uniform mat4 m_m, v_m, p_m;
+// Matrices
+uniform mat4 m_m;
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
 
 // Light properties
 uniform vec3 light_position;
@@ -0,0 +1,59 @@
+#version 460 core
+
+// permutations, set by ShaderProgram defines (see App::init_assets)
+#ifndef TEXTURE_ARRAY
+#define TEXTURE_ARRAY 0 // lighting_indirect.vert input: tex0 is a sampler2DArray, material and layer come per draw
+#endif
+
+// G-buffer targets (see DeferredRenderer.hpp)
+layout (location = 0) out vec4 g_albedo;
+layout (location = 1) out vec4 g_normal;   // xyz = view space normal, w = shininess
+layout (location = 2) out vec4 g_ambient;
+layout (location = 3) out vec4 g_diffuse;
+layout (location = 4) out vec4 g_specular;
+
+#if TEXTURE_ARRAY
+// Texture array, layer comes per draw
+uniform sampler2DArray tex0;
+#else
+// Material properties
+uniform vec3 ambient_material;
+uniform vec3 diffuse_material;
+uniform vec3 specular_material;
+uniform float specular_shinines;
+
+// Texture
+uniform sampler2D tex0;
+#endif
+
+// Input from vertex shader (lighting.vert, lighting_indirect.vert with TEXTURE_ARRAY)
+in VS_OUT {
+    vec3 FragPos; // Fragment position in View Space
+    vec3 N;       // Normal in View Space
+    vec3 V;       // View vector in View Space
+    vec2 texCoord;
+    vec3 WorldPos; // World position slightly in front of the surface
+#if TEXTURE_ARRAY
+    flat vec3 ambient_material;
+    flat vec3 diffuse_material;
+    flat vec3 specular_material;
+    flat float specular_shinines;
+    flat int layer;
+#endif
+} fs_in;
+
+void main(void) {
+#if TEXTURE_ARRAY
+    g_albedo = vec4(texture(tex0, vec3(fs_in.texCoord, fs_in.layer)).rgb, 1.0);
+    g_normal = vec4(normalize(fs_in.N), fs_in.specular_shinines);
+    g_ambient = vec4(fs_in.ambient_material, 1.0);
+    g_diffuse = vec4(fs_in.diffuse_material, 1.0);
+    g_specular = vec4(fs_in.specular_material, 1.0);
+#else
+    g_albedo = vec4(texture(tex0, fs_in.texCoord).rgb, 1.0);
+    g_normal = vec4(normalize(fs_in.N), specular_shinines);
+    g_ambient = vec4(ambient_material, 1.0);
+    g_diffuse = vec4(diffuse_material, 1.0);
+    g_specular = vec4(specular_material, 1.0);
+#endif
+}
@@ -0,0 +1,17 @@
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNorm;
+layout (location = 2) in vec2 aTex;
+
+// screen space overlay, m_m already contains the orthographic projection
+uniform mat4 m_m = mat4(1.0f);
+
+out VS_OUT {
+    vec2 texcoord;
+} vs_out;
+
+void main() {
+    gl_Position = m_m * vec4(aPos, 1.0f);
+
+    vs_out.texcoord = aTex;
+}
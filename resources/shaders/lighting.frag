@@ -1,21 +1,47 @@
 #version 460 core
 
-#define MAX_LIGHTS 20 // This MUST match MAX_LIGHTS in App.hpp
-
 out vec4 FragColor;
 
-// Struct for light properties, matching the C++ and uniform setup
+// Light properties (see LightData in LightBuffer.hpp)
 struct Light {
-    bool isActive;
-    vec3 position; // NOTE: Received in WORLD space from C++
-    vec3 ambient_intensity;
-    vec3 diffuse_intensity;
-    vec3 specular_intensity;
+    vec4 position; // WORLD space, w = 1 if active
+    vec4 ambient_intensity; // w = range
+    vec4 diffuse_intensity;
+    vec4 specular_intensity;
+};
+
+// All lights of the level, uploaded when they change
+layout (std430, binding = 1) readonly buffer LightBuffer {
+    uint light_count;
+    Light lights[];
+};
+
+// Lights assigned to view frustum clusters (see ClusteredLighting.hpp)
+layout (std430, binding = 2) readonly buffer ClusterGrid {
+    uvec4 grid_size;   // xyz = number of clusters, w = 1 if clustering is on
+    vec4 depth_params; // x = slice scale, y = slice bias (logarithmic slices)
+    vec4 screen_size;  // xy = framebuffer size
+    uvec2 clusters[];  // x = offset to light_indices, y = light count
+};
+
+layout (std430, binding = 3) readonly buffer ClusterLights {
+    uint light_indices[];
 };
 
-// Uniforms from C++
-uniform Light lights[MAX_LIGHTS];
-uniform mat4 v_m; // View matrix (to transform light positions)
+// Precomputed light visibility per map tile (see LightVisibility.hpp)
+layout (std430, binding = 4) readonly buffer TileLights {
+    ivec4 tile_grid;    // x = cols, y = rows, z = words per tile, w = 1 if enabled
+    vec4 tile_origin;   // xy = world xz of the tile (0, 0) corner
+    uint tile_lights[]; // bitmask of lights reaching each tile
+};
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
 
 // Material properties
 uniform vec3 ambient_material;
@@ -32,8 +58,22 @@ in VS_OUT {
     vec3 N;       // Normal in View Space
     vec3 V;       // View vector in View Space
     vec2 texCoord;
+    vec3 WorldPos; // World position slightly in front of the surface
 } fs_in;
 
+// Can the light reach the fragment's map tile?
+bool light_visible(uint light) {
+    if (tile_grid.w == 0) {
+        return true;
+    }
+    ivec2 tile = ivec2(floor(fs_in.WorldPos.xz - tile_origin.xy));
+    if (any(lessThan(tile, ivec2(0))) || any(greaterThanEqual(tile, tile_grid.xy))) {
+        return true;
+    }
+    uint word = tile_lights[(tile.y * tile_grid.x + tile.x) * tile_grid.z + int(light / 32)];
+    return (word & (1u << (light % 32))) != 0;
+}
+
 void main(void) {
     // Normalize interpolated vectors from the vertex shader
     vec3 N = normalize(fs_in.N);
@@ -44,11 +84,25 @@ void main(void) {
     vec3 totalDiffuse = vec3(0.0);
     vec3 totalSpecular = vec3(0.0);
 
-    // Loop through all possible lights and accumulate their effect
-    for (int i = 0; i < MAX_LIGHTS; i++) {
-        if (lights[i].isActive) {
+    // Lights affecting this fragment: all of them, or only those of its cluster
+    uint first = 0;
+    uint count = light_count;
+    if (grid_size.w != 0) {
+        float depth = max(-fs_in.FragPos.z, 1e-4);
+        uvec3 cluster = uvec3(gl_FragCoord.xy / screen_size.xy * vec2(grid_size.xy),
+                              max(log(depth) * depth_params.x - depth_params.y, 0.0));
+        cluster = min(cluster, grid_size.xyz - 1);
+        uvec2 range = clusters[cluster.x + grid_size.x * (cluster.y + grid_size.y * cluster.z)];
+        first = range.x;
+        count = range.y;
+    }
+
+    // Loop through the lights and accumulate their effect
+    for (uint k = 0; k < count; k++) {
+        uint i = grid_size.w != 0 ? light_indices[first + k] : k;
+        if (lights[i].position.w > 0.0 && light_visible(i)) {
             // Transform the light's world position to view space
-            vec3 lightPosView = (v_m * vec4(lights[i].position, 1.0)).xyz;
+            vec3 lightPosView = (v_m * vec4(lights[i].position.xyz, 1.0)).xyz;
 
             // Calculate light vector (from fragment to light)
             vec3 L = normalize(lightPosView - fs_in.FragPos);
@@ -59,18 +113,21 @@ void main(void) {
             // Calculate distance and attenuation
             float distance = length(lightPosView - fs_in.FragPos);
             float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * (distance * distance));
+            // smooth fade to zero at the light range
+            float fade = clamp(1.0 - pow(distance / lights[i].ambient_intensity.w, 4.0), 0.0, 1.0);
+            attenuation *= fade * fade;
 
             // --- Accumulate Components ---
             // Ambient
-            totalAmbient += ambient_material * lights[i].ambient_intensity * attenuation;
+            totalAmbient += ambient_material * lights[i].ambient_intensity.rgb * attenuation;
 
             // Diffuse
             float diffFactor = max(dot(N, L), 0.0);
-            totalDiffuse += diffFactor * diffuse_material * lights[i].diffuse_intensity * attenuation;
+            totalDiffuse += diffFactor * diffuse_material * lights[i].diffuse_intensity.rgb * attenuation;
 
             // Specular
             float specFactor = pow(max(dot(R, V), 0.0), specular_shinines);
-            totalSpecular += specFactor * specular_material * lights[i].specular_intensity * attenuation;
+            totalSpecular += specFactor * specular_material * lights[i].specular_intensity.rgb * attenuation;
         }
     }
 
@@ -6,7 +6,15 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
 // Matrices
-uniform mat4 m_m, v_m, p_m;
+uniform mat4 m_m;
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
 
 // Outputs to the fragment shader
 out VS_OUT {
@@ -14,8 +22,12 @@ out VS_OUT {
     vec3 N;       // Normal in View Space
     vec3 V;       // View vector in View Space
     vec2 texCoord;
+    vec3 WorldPos; // World position slightly in front of the surface (light visibility tile)
 } vs_out;
 
+// matches depth.vert / depth_indirect.vert for the GL_EQUAL shading pass after the depth pre-pass
+invariant gl_Position;
+
 void main(void) {
     // Create Model-View matrix
     mat4 mv_m = v_m * m_m;
@@ -30,6 +42,9 @@ void main(void) {
     // Calculate view vector (from fragment to camera)
     vs_out.V = -P.xyz;
 
+    // Push the position off the surface, so wall faces fall into the tile in front of them
+    vs_out.WorldPos = vec3(m_m * aPosition) + normalize(mat3(m_m) * aNormal) * 0.01;
+
     // Pass texture coordinates through
     vs_out.texCoord = aTexCoord;
 
@@ -0,0 +1,75 @@
+#version 460 core
+
+// Vertex attributes
+layout (location = 0) in vec4 aPosition;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+// Per-draw data (see DrawData in IndirectRenderer.hpp), indexed by gl_BaseInstance
+struct DrawData {
+    mat4 model_matrix;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular; // a = shininess
+    ivec4 layer;   // x = texture array layer
+};
+
+layout (std430, binding = 0) readonly buffer DrawDataBuffer {
+    DrawData draws[];
+};
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
+
+// Outputs to the fragment shader
+out VS_OUT {
+    vec3 FragPos; // Fragment position in View Space
+    vec3 N;       // Normal in View Space
+    vec3 V;       // View vector in View Space
+    vec2 texCoord;
+    vec3 WorldPos; // World position slightly in front of the surface (light visibility tile)
+    flat vec3 ambient_material;
+    flat vec3 diffuse_material;
+    flat vec3 specular_material;
+    flat float specular_shinines;
+    flat int layer;
+} vs_out;
+
+// matches depth.vert / depth_indirect.vert for the GL_EQUAL shading pass after the depth pre-pass
+invariant gl_Position;
+
+void main(void) {
+    DrawData draw = draws[gl_BaseInstance];
+
+    // Create Model-View matrix
+    mat4 mv_m = v_m * draw.model_matrix;
+
+    // Calculate view-space coordinate (the fragment's position)
+    vec4 P = mv_m * aPosition;
+    vs_out.FragPos = P.xyz;
+
+    // Calculate normal in view space
+    vs_out.N = mat3(mv_m) * aNormal;
+
+    // Calculate view vector (from fragment to camera)
+    vs_out.V = -P.xyz;
+
+    // Push the position off the surface, so wall faces fall into the tile in front of them
+    vs_out.WorldPos = vec3(draw.model_matrix * aPosition) + normalize(mat3(draw.model_matrix) * aNormal) * 0.01;
+
+    // Pass texture coordinates and material through
+    vs_out.texCoord = aTexCoord;
+    vs_out.ambient_material = draw.ambient.rgb;
+    vs_out.diffuse_material = draw.diffuse.rgb;
+    vs_out.specular_material = draw.specular.rgb;
+    vs_out.specular_shinines = draw.specular.a;
+    vs_out.layer = draw.layer.x;
+
+    // Calculate the final clip-space position of the vertex
+    gl_Position = p_m * P;
+}
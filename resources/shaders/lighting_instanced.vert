@@ -0,0 +1,64 @@
+#version 460 core
+
+// Vertex attributes
+layout (location = 0) in vec4 aPosition;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+// Per-instance attributes (see InstanceData in InstancedRenderer.hpp)
+layout (location = 3) in mat4 aModelMatrix; // occupies locations 3-6
+layout (location = 7) in vec4 aAmbient;
+layout (location = 8) in vec4 aDiffuse;
+layout (location = 9) in vec4 aSpecular;    // a = shininess
+layout (location = 10) in int aLayer;       // texture array layer
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
+
+// Outputs to the fragment shader
+out VS_OUT {
+    vec3 FragPos; // Fragment position in View Space
+    vec3 N;       // Normal in View Space
+    vec3 V;       // View vector in View Space
+    vec2 texCoord;
+    vec3 WorldPos; // World position slightly in front of the surface (light visibility tile)
+    flat vec3 ambient_material;
+    flat vec3 diffuse_material;
+    flat vec3 specular_material;
+    flat float specular_shinines;
+    flat int layer;
+} vs_out;
+
+void main(void) {
+    // Create Model-View matrix
+    mat4 mv_m = v_m * aModelMatrix;
+
+    // Calculate view-space coordinate (the fragment's position)
+    vec4 P = mv_m * aPosition;
+    vs_out.FragPos = P.xyz;
+
+    // Calculate normal in view space
+    vs_out.N = mat3(mv_m) * aNormal;
+
+    // Calculate view vector (from fragment to camera)
+    vs_out.V = -P.xyz;
+
+    // Push the position off the surface, so wall faces fall into the tile in front of them
+    vs_out.WorldPos = vec3(aModelMatrix * aPosition) + normalize(mat3(aModelMatrix) * aNormal) * 0.01;
+
+    // Pass texture coordinates and material through
+    vs_out.texCoord = aTexCoord;
+    vs_out.ambient_material = aAmbient.rgb;
+    vs_out.diffuse_material = aDiffuse.rgb;
+    vs_out.specular_material = aSpecular.rgb;
+    vs_out.specular_shinines = aSpecular.a;
+    vs_out.layer = aLayer;
+
+    // Calculate the final clip-space position of the vertex
+    gl_Position = p_m * P;
+}
@@ -0,0 +1,16 @@
+#version 460 core
+
+out vec4 FragColor;
+
+// Texture
+uniform sampler2D tex0;
+// Baked ambient and diffuse light, materials already applied (see LightmapBaker.hpp)
+uniform sampler2D lightmap;
+
+in vec2 texCoord;
+in vec2 lightmapCoord;
+
+void main(void) {
+    vec3 light = texture(lightmap, lightmapCoord).rgb;
+    FragColor = vec4(light * texture(tex0, texCoord).rgb, 1.0);
+}
@@ -0,0 +1,33 @@
+#version 460 core
+
+// Vertex attributes (StaticLevelMesh, lightmap coordinates from set_lightmap_uvs)
+layout (location = 0) in vec4 aPosition;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec2 aLightmapCoord;
+
+// Matrices
+uniform mat4 m_m;
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
+
+out vec2 texCoord;
+out vec2 lightmapCoord;
+
+// matches depth.vert for the GL_EQUAL shading pass after the depth pre-pass
+invariant gl_Position;
+
+void main(void) {
+    // same operations as lighting.vert
+    mat4 mv_m = v_m * m_m;
+    vec4 P = mv_m * aPosition;
+
+    texCoord = aTexCoord;
+    lightmapCoord = aLightmapCoord;
+    gl_Position = p_m * P;
+}
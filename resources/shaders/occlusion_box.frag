@@ -0,0 +1,8 @@
+#version 460 core
+
+// color writes are masked, only the depth test of the box matters
+out vec4 FragColor;
+
+void main() {
+    FragColor = vec4(1.0f);
+}
@@ -0,0 +1,17 @@
+#version 460 core
+layout (location = 0) in vec3 aPos;
+
+// unit cube scaled and moved to the tested bounding box
+uniform mat4 m_m = mat4(1.0f);
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
+
+void main() {
+    gl_Position = p_m * v_m * m_m * vec4(aPos, 1.0f);
+}
@@ -0,0 +1,19 @@
+#version 460 core
+
+// weighted blended OIT targets (see WeightedOIT.hpp)
+uniform sampler2D accum;
+uniform sampler2D revealage;
+
+out vec4 FragColor;
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float reveal = texelFetch(revealage, texel, 0).r;
+    if (reveal >= 1.0f) {
+        // no transparent surface here
+        discard;
+    }
+    vec4 sum = texelFetch(accum, texel, 0);
+    // weighted average color, alpha = remaining visibility of the opaque image
+    FragColor = vec4(sum.rgb / max(sum.a, 1e-5f), reveal);
+}
@@ -0,0 +1,25 @@
+#version 460 core
+
+// (interpolated) input from previous pipeline stage
+in VS_OUT {
+    vec2 texcoord;
+    flat int layer;
+} fs_in;
+
+// uniform variables
+uniform sampler2DArray tex0; // all sprite textures, one per layer
+uniform vec4 u_diffuse_color = vec4(1.0f);
+
+// weighted blended OIT targets (see WeightedOIT.hpp)
+layout (location = 0) out vec4 accum;
+layout (location = 1) out float revealage;
+
+void main() {
+    vec4 color = u_diffuse_color * texture(tex0, vec3(fs_in.texcoord, fs_in.layer));
+
+    // depth weight of McGuire & Bavoil, equation 10
+    float weight = clamp(pow(min(1.0f, color.a * 10.0f) + 0.01f, 3.0f) * 1e8f *
+                         pow(1.0f - gl_FragCoord.z * 0.9f, 3.0f), 1e-2f, 3e3f);
+    accum = vec4(color.rgb * color.a, color.a) * weight;
+    revealage = color.a;
+}
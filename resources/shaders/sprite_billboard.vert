@@ -0,0 +1,34 @@
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNorm;
+layout (location = 2) in vec2 aTex;
+
+// Per-instance sprite (see SpriteRenderer.hpp): xyz = world position, w = texture array layer
+layout (location = 3) in vec4 aSprite;
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
+
+out VS_OUT {
+    vec2 texcoord;
+    flat int layer;
+} vs_out;
+
+void main() {
+    // turn the quad around Y to face the camera (the quad faces +Z in model space)
+    vec2 to_camera = camera_position.xz - aSprite.xz;
+    vec2 dir = dot(to_camera, to_camera) > 1e-8f ? normalize(to_camera) : vec2(0.0f, 1.0f);
+    vec3 right = vec3(dir.y, 0.0f, -dir.x);
+    vec3 forward = vec3(dir.x, 0.0f, dir.y);
+    vec3 world = aSprite.xyz + right * aPos.x + vec3(0.0f, aPos.y, 0.0f) + forward * aPos.z;
+
+    gl_Position = p_m * v_m * vec4(world, 1.0f);
+
+    vs_out.texcoord = aTex;
+    vs_out.layer = int(aSprite.w + 0.5f);
+}
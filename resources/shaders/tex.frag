@@ -1,5 +1,10 @@
 #version 460 core
 
+// permutations, set by ShaderProgram defines (e.g. "ALPHA_TEST 1" in models.json)
+#ifndef ALPHA_TEST
+#define ALPHA_TEST 0 // discard below alpha_cutoff, depth writes stay on
+#endif
+
 // (interpolated) input from previous pipeline stage
 in VS_OUT {
     vec2 texcoord;
@@ -8,10 +13,21 @@ in VS_OUT {
 // uniform variables
 uniform sampler2D tex0; // Texture sampler uniform
 uniform vec4 u_diffuse_color = vec4(1.0f);
+#if ALPHA_TEST
+uniform float alpha_cutoff = 0.5f;
+#endif
 
 // mandatory: final output color
 out vec4 FragColor;
 
 void main() {
-    FragColor = u_diffuse_color * texture(tex0, fs_in.texcoord); // Sample texture
+    vec4 color = u_diffuse_color * texture(tex0, fs_in.texcoord); // Sample texture
+#if ALPHA_TEST
+    if (color.a < alpha_cutoff) {
+        discard;
+    }
+    // edge sharpened to about one pixel, used only with alpha-to-coverage
+    color.a = clamp((color.a - alpha_cutoff) / max(fwidth(color.a), 1e-4f) + 0.5f, 0.0f, 1.0f);
+#endif
+    FragColor = color;
 }
\ No newline at end of file
@@ -3,10 +3,15 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNorm;
 layout (location = 2) in vec2 aTex;
 
-// RENAMED these uniforms to match the C++ code
-uniform mat4 p_m = mat4(1.0f);
 uniform mat4 m_m = mat4(1.0f);
-uniform mat4 v_m = mat4(1.0f);
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
 
 out VS_OUT {
     vec2 texcoord;
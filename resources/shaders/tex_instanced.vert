@@ -0,0 +1,26 @@
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNorm;
+layout (location = 2) in vec2 aTex;
+
+// Per-instance model matrix (see InstanceData in InstancedRenderer.hpp)
+layout (location = 3) in mat4 aModelMatrix; // occupies locations 3-6
+
+// Per-frame data (see FrameUniforms.hpp)
+layout (std140, binding = 0) uniform Frame {
+    mat4 v_m;
+    mat4 p_m;
+    vec4 camera_position; // world space, w unused
+    float time;
+};
+
+out VS_OUT {
+    vec2 texcoord;
+} vs_out;
+
+void main() {
+    // Outputs the positions/coordinates of all vertices
+    gl_Position = p_m * v_m * aModelMatrix * vec4(aPos, 1.0f);
+    
+    vs_out.texcoord = aTex;
+}